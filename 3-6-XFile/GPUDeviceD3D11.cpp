@@ -1,11 +1,19 @@
 ﻿#include "GPUDeviceD3D11.h"
 #include <d3dcompiler.h>
-#include <DirectXTex.h>
+#include <chrono>
+#include <filesystem>
 #include <numbers>
-#include "xfile/XFileReader.h"
+#include <string>
+#include "xfile/XFileNormalGeneration.h"
+#include "xfile/XFileSkinning.h"
+#include "xfile/XFileVertexCache.h"
+#include "xfile/XFileVertexWelding.h"
 
 namespace
 {
+	constexpr char MeshFileName[] = "map.x";
+	constexpr char CookedMeshFileName[] = "map.xcm";
+
 	template <class T, size_t N>
 	constexpr uint32_t countof(const T (&)[N]) noexcept
 	{
@@ -68,27 +76,42 @@ namespace
 		return true;
 	}
 
-	bool createTextureSRV(ID3D11Device * p_device, const wchar_t * p_file_path, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> & p_srv)
+	// 別のスレッドから呼ぶので，デバイスは使わずに画像を読むだけにする
+	std::unique_ptr<DirectX::ScratchImage> loadTextureImage(const std::string & file_name)
 	{
-		DirectX::TexMetadata tex_meta_data;
-		DirectX::ScratchImage scratch_image;
+		if(FAILED(CoInitializeEx(nullptr, COINIT_MULTITHREADED)))
+		{
+			return nullptr;
+		}
 
+		wchar_t path[MAX_PATH];
+		mbstowcs(path, file_name.c_str(), sizeof(path) / sizeof(path[0]));
+
+		auto p_scratch_image = std::make_unique<DirectX::ScratchImage>();
 		HRESULT hr = DirectX::LoadFromWICFile(
-			p_file_path,
+			path,
 			DirectX::WIC_FLAGS_NONE,
-			&tex_meta_data,
-			scratch_image
+			nullptr,
+			*p_scratch_image
 		);
+
+		CoUninitialize();
+
 		if(FAILED(hr))
 		{
-			return false;
+			return nullptr;
 		}
 
-		hr = DirectX::CreateShaderResourceView(
+		return p_scratch_image;
+	}
+
+	bool createTextureSRV(ID3D11Device * p_device, const DirectX::ScratchImage & scratch_image, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> & p_srv)
+	{
+		HRESULT hr = DirectX::CreateShaderResourceView(
 			p_device,
 			scratch_image.GetImage(0, 0, 0),
 			1,
-			tex_meta_data,
+			scratch_image.GetMetadata(),
 			&p_srv
 		);
 		if(FAILED(hr))
@@ -99,6 +122,58 @@ namespace
 		return true;
 	}
 
+	bool isSameFile(const std::string & a, const std::string & b)
+	{
+		return std::filesystem::path(a).lexically_normal() == std::filesystem::path(b).lexically_normal();
+	}
+
+	// 変換済みのメッシュが元のファイルより新しければ使う
+	bool isCookedMeshUpToDate(const char * p_cooked_file_name, const char * p_source_file_name)
+	{
+		std::error_code ec;
+		auto cooked_time = std::filesystem::last_write_time(p_cooked_file_name, ec);
+		if(ec)
+		{
+			return false;
+		}
+
+		auto source_time = std::filesystem::last_write_time(p_source_file_name, ec);
+		if(ec)
+		{
+			return true;
+		}
+
+		return source_time <= cooked_time;
+	}
+
+	// スキンメッシュをフレームの姿勢に合わせた形へ置き換え，普通のメッシュとして扱えるようにする
+	// ファイルの法線は変換前の形に合わせてあるので，変換後の位置から作り直す
+	bool poseSkinnedMesh(xfile::XFileMesh & mesh, const xfile::XFileFrameTable & frames)
+	{
+		std::vector<xfile::XFileMatrix> bone_matrices;
+		xfile::computeSkinningMatrices(mesh, frames, bone_matrices);
+
+		std::vector<xfile::XFileVector> positions(mesh.vertices.size());
+		xfile::XFileSkinningTarget target
+		{
+			.pVertices = positions.data(),
+			.stride = sizeof(xfile::XFileVector),
+			.positionOffset = 0
+		};
+		if(!xfile::skinVertices(mesh, bone_matrices, xfile::XFileSkinningMode::LinearBlend, target))
+		{
+			return false;
+		}
+
+		mesh.vertices = std::move(positions);
+		mesh.preciseVertices.clear();
+		mesh.skinMeshHeader = {};
+		mesh.skinWeights.clear();
+		mesh.influences.clear();
+
+		return xfile::generateNormals(mesh);
+	}
+
 #if 0
 	struct Vertex
 	{
@@ -145,11 +220,30 @@ bool GPUDeviceD3D11::initialize(HWND hWnd)
 		return false;
 	}
 
-	if(!loadMesh())
+	xfile::XFileCookedMesh cooked_mesh;
+	if(isCookedMeshUpToDate(CookedMeshFileName, MeshFileName) && cooked_mesh.open(CookedMeshFileName))
 	{
-		return false;
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		std::string texture_file_name;
+		if(!loadCookedMesh(cooked_mesh, vertices, indices, texture_file_name))
+		{
+			return false;
+		}
+
+		if(!applyMesh(std::move(vertices), std::move(indices), std::move(texture_file_name)))
+		{
+			return false;
+		}
+	}
+	else
+	{
+		mpMeshLoad = std::make_unique<xfile::XFileAsyncLoad>(MeshFileName);
 	}
 
+	// 監視できなくても，読み込み直しができないだけで描画は続けられる
+	mWatcher.open(".");
+
 	ComPtr<ID3DBlob> p_vertex_shader_blob;
 	if(!loadShader(L"shaders.hlsl", "VS", "vs_5_0", p_vertex_shader_blob))
 	{
@@ -165,16 +259,6 @@ bool GPUDeviceD3D11::initialize(HWND hWnd)
 		return false;
 	}
 
-	if(!createVertexBuffer())
-	{
-		return false;
-	}
-
-	if(!createIndexBuffer())
-	{
-		return false;
-	}
-
 	// Vertex Shader (VS)
 	if(!createVertexShader(
 		p_vertex_shader_blob->GetBufferPointer(),
@@ -243,6 +327,21 @@ bool GPUDeviceD3D11::initialize(HWND hWnd)
 
 bool GPUDeviceD3D11::render()
 {
+	if(!updateFileChanges())
+	{
+		return false;
+	}
+
+	if(!updateMeshLoad())
+	{
+		return false;
+	}
+
+	if(!updateTextureLoad())
+	{
+		return false;
+	}
+
 	auto world = DirectX::XMMatrixIdentity();
 
 	auto eye = DirectX::XMVectorSet(0.0f, 5.0f, -10.0f, 1.0f);
@@ -283,7 +382,11 @@ bool GPUDeviceD3D11::render()
 
 	mpImmediateContext->ClearRenderTargetView(mpRTV.Get(), mClearColor);
 
-	mpImmediateContext->DrawIndexed(countof(mIndices), 0, 0);
+	// 読み込みが終わるまではクリアだけを行う
+	if(mpIndexBuffer)
+	{
+		mpImmediateContext->DrawIndexed(countof(mIndices), 0, 0);
+	}
 
 	uint32_t present_flags = 0;
 	mpSwapChain->Present(0, present_flags);
@@ -358,68 +461,266 @@ bool GPUDeviceD3D11::retrieveDXGIFactory()
 	return true;
 }
 
-bool GPUDeviceD3D11::loadMesh()
+bool GPUDeviceD3D11::updateFileChanges()
 {
-	xfile::XFileReader reader;
-	if(!reader.open("map.x"))
+	// 監視がエラーで止まっていれば開き直す．開けなければ次のフレームでまた試す
+	if(mWatcher.failed())
 	{
-		return false;
+		mWatcher.close();
+		mWatcher.open(".");
+	}
+
+	std::vector<std::string> file_names;
+	if(!mWatcher.takeChanges(file_names))
+	{
+		return true;
+	}
+
+	for(const auto & file_name : file_names)
+	{
+		if(isSameFile(file_name, MeshFileName))
+		{
+			// 読み込み中のものがあれば，破棄すると打ち切られる
+			mpMeshLoad = std::make_unique<xfile::XFileAsyncLoad>(MeshFileName);
+		}
+		else if(!mTextureFileName.empty() && isSameFile(file_name, mTextureFileName))
+		{
+			startTextureLoad();
+		}
+	}
+
+	return true;
+}
+
+bool GPUDeviceD3D11::updateMeshLoad()
+{
+	if(!mpMeshLoad || !mpMeshLoad->isReady())
+	{
+		return true;
+	}
+
+	auto result = mpMeshLoad->get();
+	mpMeshLoad.reset();
+
+	// 読み込み直しに失敗した場合は，保存し直されるまでそれまでのメッシュで描画を続ける
+	const bool reloading = static_cast<bool>(mpIndexBuffer);
+
+	if(!result.succeeded)
+	{
+		return reloading;
 	}
 
-	xfile::XFile xfile;
-	if(!reader.read(xfile))
+	// 遅延読み込みした子が残っていれば，法線などを使う前に読み込んでおく
+	if(!result.xfile.loadLazyObjects())
+	{
+		return reloading;
+	}
+
+	// 描画するのと同じ形を変換済みのメッシュへ書き出すので，姿勢や法線はここで決めておく
+	// 法線の無いファイルは陰影を付けられないので，ここで作る
+	for(auto & mesh : result.xfile.meshes)
+	{
+		if(!mesh.influences.empty() && !poseSkinnedMesh(mesh, result.xfile.frames))
+		{
+			return reloading;
+		}
+
+		if(xfile::needsNormals(mesh) && !xfile::generateNormals(mesh))
+		{
+			return reloading;
+		}
+	}
+
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	std::string texture_file_name;
+	if(!loadMesh(result.xfile, vertices, indices, texture_file_name))
+	{
+		return reloading;
+	}
+
+	if(!applyMesh(std::move(vertices), std::move(indices), std::move(texture_file_name)))
+	{
+		return reloading;
+	}
+
+	// 次回からは変換済みのメッシュを使う
+	startMeshCook(std::move(result.xfile));
+
+	return true;
+}
+
+bool GPUDeviceD3D11::updateTextureLoad()
+{
+	if(!mTextureLoad.valid() || mTextureLoad.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+	{
+		return true;
+	}
+
+	// 読めなかった場合はそれまでのテクスチャを使い続ける
+	auto p_scratch_image = mTextureLoad.get();
+	if(!p_scratch_image)
+	{
+		return true;
+	}
+
+	ComPtr<ID3D11ShaderResourceView> p_srv;
+	if(!createTextureSRV(mpDevice.Get(), *p_scratch_image, p_srv))
+	{
+		return true;
+	}
+
+	mpTextureSRV = std::move(p_srv);
+
+	return true;
+}
+
+void GPUDeviceD3D11::startTextureLoad()
+{
+	// 前の読み込みが残っていれば，その終わりを待ってから始める
+	mTextureLoad = std::async(std::launch::async, loadTextureImage, mTextureFileName);
+}
+
+void GPUDeviceD3D11::startMeshCook(xfile::XFile && xfile)
+{
+	// 同じファイルへ同時に書き出さないように，前の書き出しが残っていれば終わるのを待つ
+	// 書き出せなくても描画は続けられるので，結果は見ない
+	mMeshCook = std::async(std::launch::async, [xfile = std::move(xfile)]()
+	{
+		return xfile::XFileCookedMesh::cook(xfile, CookedMeshFileName);
+	});
+}
+
+bool GPUDeviceD3D11::loadMesh(
+	const xfile::XFile & xfile,
+	std::vector<Vertex> & vertices,
+	std::vector<uint32_t> & indices,
+	std::string & texture_file_name
+)
+{
+	// 読み飛ばした子が残っていると法線やテクスチャ座標が空に見えるので，受け付けない
+	if(xfile.meshes.size() != 1 || xfile.hasLazyObjects())
 	{
 		return false;
 	}
 
-	if(!reader.close())
+	// スキンメッシュはposeSkinnedMeshで姿勢を付けてから渡す
+	auto & mesh = xfile.meshes[0];
+	if(!mesh.influences.empty())
 	{
 		return false;
 	}
 
-	if(xfile.meshes.size() != 1)
+	// 法線は位置と別の番号で引くので，位置と法線の番号の組ごとに頂点を作る
+	xfile::XFileVertexWelding welding;
+	if(!welding.setup(mesh))
 	{
 		return false;
 	}
 
-	auto & vertices = xfile.meshes[0].vertices;
-	auto & textureCoords = xfile.meshes[0].textureCoords.textureCoords;
-	mVertices.resize(vertices.size());
+	// テクスチャ座標は位置と同じ番号で引く
+	auto & texture_coords = mesh.textureCoords.textureCoords;
+	const bool has_uv = texture_coords.size() == mesh.vertices.size();
+	auto & positions = mesh.vertices;
+	const bool has_normals = welding.hasNormals;
+	vertices.resize(welding.vertexCount());
 	for(size_t i = 0; i < vertices.size(); ++i)
 	{
-		mVertices[i].position.x = vertices[i].x;
-		mVertices[i].position.y = vertices[i].y;
-		mVertices[i].position.z = vertices[i].z;
-		mVertices[i].uv.x = textureCoords[i].u;
-		mVertices[i].uv.y = textureCoords[i].v;
+		auto position_index = welding.sourceIndex(i, xfile::XFileVertexWelding::PositionStream);
+		vertices[i].position = DirectX::XMFLOAT3(positions[position_index].x, positions[position_index].y, positions[position_index].z);
+		vertices[i].normal = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+		if(has_normals)
+		{
+			auto & normal = mesh.normals.normals[welding.sourceIndex(i, xfile::XFileVertexWelding::NormalStream)];
+			vertices[i].normal = DirectX::XMFLOAT3(normal.x, normal.y, normal.z);
+		}
+		vertices[i].uv = has_uv ? DirectX::XMFLOAT2(texture_coords[position_index].u, texture_coords[position_index].v) : DirectX::XMFLOAT2(0.0f, 0.0f);
 	}
 
-	uint32_t index_count = 0;
-	auto & faces = xfile.meshes[0].faces;
-	for(const auto & face : faces)
+	// 面は作ったときの順番のままなので，頂点キャッシュに合わせて並べ替える
+	indices = std::move(welding.indices);
+	if(!xfile::optimizeVertexCache(indices, vertices.size()))
 	{
-		index_count += static_cast<uint32_t>(face.faceVertexIndices.size());
+		return false;
 	}
 
-	mIndices.resize(index_count);
-	for(size_t base = 0; const auto & face : faces)
+	auto & materials = mesh.materialList.materials;
+	if(!materials.empty())
 	{
-		size_t offset = 0;
-		for(; offset < face.faceVertexIndices.size(); ++offset)
-		{
-			mIndices[base + offset] = face.faceVertexIndices[offset];
-		}
-		base += offset;
+		texture_file_name = materials[0].textureFilename.filename;
 	}
 
-	auto & material = xfile.meshes[0].materialList.materials[0];
-	if(!material.textureFilename.filename.empty())
+	return true;
+}
+
+bool GPUDeviceD3D11::loadCookedMesh(
+	const xfile::XFileCookedMesh & cooked_mesh,
+	std::vector<Vertex> & vertices,
+	std::vector<uint32_t> & indices,
+	std::string & texture_file_name
+)
+{
+	static_assert(sizeof(Vertex) == sizeof(xfile::XFileCookedVertex));
+
+	auto cooked_vertices = cooked_mesh.vertices();
+	vertices.resize(cooked_vertices.size());
+	memcpy(vertices.data(), cooked_vertices.data(), cooked_vertices.size_bytes());
+
+	auto cooked_indices = cooked_mesh.indices();
+	indices.assign(cooked_indices.begin(), cooked_indices.end());
+
+	if(!cooked_mesh.materials().empty())
 	{
-		wchar_t path[MAX_PATH];
-		mbstowcs(path, material.textureFilename.filename.c_str(), sizeof(path) / sizeof(path[0]));
-		if(!createTextureSRV(mpDevice.Get(), path, mpTextureSRV))
+		texture_file_name = cooked_mesh.textureFilename(cooked_mesh.materials()[0]);
+	}
+
+	return true;
+}
+
+bool GPUDeviceD3D11::applyMesh(std::vector<Vertex> && vertices, std::vector<uint32_t> && indices, std::string && texture_file_name)
+{
+	// 中身が変わったバッファだけを作り直す
+	// すべて作り終えてから差し替えるので，途中で失敗してもそれまでのメッシュが残る
+	const bool vertices_changed = vertices.size() != mVertices.size()
+		|| memcmp(vertices.data(), mVertices.data(), bytesof(vertices)) != 0;
+	const bool indices_changed = indices.size() != mIndices.size()
+		|| memcmp(indices.data(), mIndices.data(), bytesof(indices)) != 0;
+
+	// Input Assembler (IA)
+	ComPtr<ID3D11Buffer> p_vertex_buffer;
+	if(vertices_changed && !createVertexBuffer(vertices, p_vertex_buffer))
+	{
+		return false;
+	}
+
+	ComPtr<ID3D11Buffer> p_index_buffer;
+	if(indices_changed && !createIndexBuffer(indices, p_index_buffer))
+	{
+		return false;
+	}
+
+	if(vertices_changed)
+	{
+		mVertices = std::move(vertices);
+		mpVertexBuffer = std::move(p_vertex_buffer);
+		mVertexStride = sizeof(Vertex);
+		mVertexOffset = 0;
+	}
+
+	if(indices_changed)
+	{
+		mIndices = std::move(indices);
+		mpIndexBuffer = std::move(p_index_buffer);
+	}
+
+	if(texture_file_name != mTextureFileName)
+	{
+		mTextureFileName = std::move(texture_file_name);
+		mpTextureSRV.Reset();
+
+		if(!mTextureFileName.empty())
 		{
-			return false;
+			startTextureLoad();
 		}
 	}
 
@@ -439,6 +740,15 @@ bool GPUDeviceD3D11::createInputLayout(const void * p_bytecode, size_t bytecode_
 			.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA,
 			.InstanceDataStepRate = 0
 		},
+		{
+			.SemanticName = "NORMAL",
+			.SemanticIndex = 0,
+			.Format = DXGI_FORMAT_R32G32B32_FLOAT,
+			.InputSlot = 0,
+			.AlignedByteOffset = offsetof(Vertex, normal),
+			.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA,
+			.InstanceDataStepRate = 0
+		},
 		{
 			.SemanticName = "TEXCOORD",
 			.SemanticIndex = 0,
@@ -465,11 +775,11 @@ bool GPUDeviceD3D11::createInputLayout(const void * p_bytecode, size_t bytecode_
 	return true;
 }
 
-bool GPUDeviceD3D11::createVertexBuffer()
+bool GPUDeviceD3D11::createVertexBuffer(const std::vector<Vertex> & vertices, ComPtr<ID3D11Buffer> & p_vertex_buffer)
 {
 	D3D11_BUFFER_DESC buffer_desc
 	{
-		.ByteWidth = bytesof(mVertices),
+		.ByteWidth = bytesof(vertices),
 		.Usage = D3D11_USAGE_IMMUTABLE,
 		.BindFlags = D3D11_BIND_VERTEX_BUFFER,
 		.CPUAccessFlags = 0,
@@ -479,7 +789,7 @@ bool GPUDeviceD3D11::createVertexBuffer()
 
 	D3D11_SUBRESOURCE_DATA subresource_data
 	{
-		.pSysMem = mVertices.data(),
+		.pSysMem = vertices.data(),
 		.SysMemPitch = 0,
 		.SysMemSlicePitch = 0
 	};
@@ -487,24 +797,21 @@ bool GPUDeviceD3D11::createVertexBuffer()
 	HRESULT hr = mpDevice->CreateBuffer(
 		&buffer_desc,
 		&subresource_data,
-		&mpVertexBuffer
+		&p_vertex_buffer
 	);
 	if(FAILED(hr))
 	{
 		return false;
 	}
 
-	mVertexStride = sizeof(mVertices[0]);
-	mVertexOffset = 0;
-
 	return true;
 }
 
-bool GPUDeviceD3D11::createIndexBuffer()
+bool GPUDeviceD3D11::createIndexBuffer(const std::vector<uint32_t> & indices, ComPtr<ID3D11Buffer> & p_index_buffer)
 {
 	D3D11_BUFFER_DESC buffer_desc
 	{
-		.ByteWidth = bytesof(mIndices),
+		.ByteWidth = bytesof(indices),
 		.Usage = D3D11_USAGE_IMMUTABLE,
 		.BindFlags = D3D11_BIND_INDEX_BUFFER,
 		.CPUAccessFlags = 0,
@@ -514,7 +821,7 @@ bool GPUDeviceD3D11::createIndexBuffer()
 
 	D3D11_SUBRESOURCE_DATA subresource_data
 	{
-		.pSysMem = mIndices.data(),
+		.pSysMem = indices.data(),
 		.SysMemPitch = 0,
 		.SysMemSlicePitch = 0
 	};
@@ -522,7 +829,7 @@ bool GPUDeviceD3D11::createIndexBuffer()
 	HRESULT hr = mpDevice->CreateBuffer(
 		&buffer_desc,
 		&subresource_data,
-		&mpIndexBuffer
+		&p_index_buffer
 	);
 	if(FAILED(hr))
 	{
@@ -3,12 +3,18 @@
 #define GPU_DEVICE_D3D11_H_INCLUDED
 
 #include <cstdint>
+#include <future>
+#include <memory>
 #include <vector>
 #include <string>
 #include <d3d11_4.h>
 #include <dxgi1_6.h>
 #include <wrl/client.h>
 #include <DirectXMath.h>
+#include <DirectXTex.h>
+#include "xfile/XFileAsyncLoad.h"
+#include "xfile/XFileCookedMesh.h"
+#include "xfile/XFileWatcher.h"
 
 class GPUDeviceD3D11
 {
@@ -21,15 +27,39 @@ private:
 	template <class T>
 	using ComPtr = Microsoft::WRL::ComPtr<T>;
 
+	struct Vertex
+	{
+		DirectX::XMFLOAT3 position;
+		DirectX::XMFLOAT3 normal;
+		DirectX::XMFLOAT2 uv;
+	};
+
 	bool createDevice();
 	bool retrieveDXGIFactory();
 
-	bool loadMesh();
+	bool updateFileChanges();
+	bool updateMeshLoad();
+	bool updateTextureLoad();
+	bool loadMesh(
+		const xfile::XFile & xfile,
+		std::vector<Vertex> & vertices,
+		std::vector<uint32_t> & indices,
+		std::string & texture_file_name
+	);
+	bool loadCookedMesh(
+		const xfile::XFileCookedMesh & cooked_mesh,
+		std::vector<Vertex> & vertices,
+		std::vector<uint32_t> & indices,
+		std::string & texture_file_name
+	);
+	bool applyMesh(std::vector<Vertex> && vertices, std::vector<uint32_t> && indices, std::string && texture_file_name);
+	void startTextureLoad();
+	void startMeshCook(xfile::XFile && xfile);
 
 	// Input Assembler (IA)
 	bool createInputLayout(const void * p_bytecode, size_t bytecode_length);
-	bool createVertexBuffer();
-	bool createIndexBuffer();
+	bool createVertexBuffer(const std::vector<Vertex> & vertices, ComPtr<ID3D11Buffer> & p_vertex_buffer);
+	bool createIndexBuffer(const std::vector<uint32_t> & indices, ComPtr<ID3D11Buffer> & p_index_buffer);
 
 	// Vertex Shader (VS)
 	bool createVertexShader(const void * p_bytecode, size_t bytecode_length);
@@ -60,14 +90,20 @@ private:
 
 	ComPtr<IDXGIFactory2> mpDXGIFactory;
 
+	// メッシュはバックグラウンドで読み込み，終わったフレームでバッファを作る
+	std::unique_ptr<xfile::XFileAsyncLoad> mpMeshLoad;
+
+	// メッシュやテクスチャのファイルが書き換えられたら読み込み直し，次のフレームの前に差し替える
+	xfile::XFileWatcher mWatcher;
+	std::string mTextureFileName;
+	std::future<std::unique_ptr<DirectX::ScratchImage>> mTextureLoad;
+
+	// 変換済みメッシュの書き出しは描画を止めないようにバックグラウンドで行う
+	std::future<bool> mMeshCook;
+
 	// Input Assembler (IA)
 	ComPtr<ID3D11InputLayout> mpInputLayout;
 
-	struct Vertex
-	{
-		DirectX::XMFLOAT3 position;
-		DirectX::XMFLOAT2 uv;
-	};
 	std::vector<Vertex> mVertices;
 	std::vector<uint32_t> mIndices;
 
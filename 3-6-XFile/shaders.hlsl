@@ -1,15 +1,20 @@
 struct VSInput
 {
 	float4 position : POSITION;
+	float3 normal : NORMAL;
 	float2 uv : TEXCOORD;
 };
 
 struct PSInput
 {
 	float4 position : SV_POSITION;
+	float3 normal : NORMAL;
 	float2 uv : TEXCOORD;
 };
 
+static const float3 lightDirection = normalize(float3(0.5f, -1.0f, 0.5f));
+static const float ambient = 0.3f;
+
 Texture2D tex;
 SamplerState smp;
 
@@ -23,6 +28,7 @@ PSInput VS(VSInput input)
 	PSInput output;
 
 	output.position = mul(input.position, wvp);
+	output.normal = input.normal;
 	output.uv = input.uv;
 
 	return output;
@@ -30,5 +36,8 @@ PSInput VS(VSInput input)
 
 float4 PS(PSInput input) : SV_TARGET
 {
-	return tex.Sample(smp, input.uv);
+	float diffuse = saturate(dot(normalize(input.normal), -lightDirection));
+	float4 color = tex.Sample(smp, input.uv);
+
+	return float4(color.rgb * (ambient + (1.0f - ambient) * diffuse), color.a);
 }
\ No newline at end of file
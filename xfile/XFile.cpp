@@ -2,4 +2,66 @@
 
 namespace xfile
 {
+	void XFile::append(XFile && other)
+	{
+		auto frame_offset = static_cast<uint32_t>(frames.size());
+		frames.append(other.frames);
+
+		for(auto & mesh : other.meshes)
+		{
+			if(mesh.frameIndex != XFileFrameTable::NoParent)
+			{
+				mesh.frameIndex += frame_offset;
+			}
+
+			meshes.emplace_back(std::move(mesh));
+		}
+
+		for(auto & animation_set : other.animationSets)
+		{
+			animationSets.emplace_back(std::move(animation_set));
+		}
+	}
+
+	bool XFile::loadLazyObjects()
+	{
+		bool succeeded = true;
+		for(auto & mesh : meshes)
+		{
+			succeeded = mesh.loadLazyObjects() && succeeded;
+		}
+
+		return succeeded;
+	}
+
+	bool XFile::hasLazyObjects() const noexcept
+	{
+		for(const auto & mesh : meshes)
+		{
+			if(!mesh.lazyObjects.empty())
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void XFile::finalize()
+	{
+		frames.updateWorldMatrices();
+
+		for(auto & mesh : meshes)
+		{
+			for(auto & skin_weights : mesh.skinWeights)
+			{
+				skin_weights.frameIndex = frames.find(skin_weights.transformNodeName);
+			}
+		}
+
+		for(auto & animation_set : animationSets)
+		{
+			animation_set.bind(frames);
+		}
+	}
 }
@@ -4,12 +4,29 @@
 
 #include <vector>
 #include "XFileMesh.h"
+#include "XFileFrameTable.h"
+#include "XFileAnimationSet.h"
 
 namespace xfile
 {
 	struct XFile
 	{
+		// otherのフレームとメッシュを後ろに繋げる．フレームの番号は付け替える
+		void append(XFile && other);
+
+		// フレームの階層を読み終えてから，ワールド行列とアニメーションやボーンの対象を確定する
+		void finalize();
+
+		// 全メッシュの読み飛ばした子オブジェクトを読み込む
+		// XFileWriterやXFileCookedMeshは遅延読み込みの子が残ったメッシュを受け付けないので，先にこれを呼ぶ
+		bool loadLazyObjects();
+
+		// 遅延読み込みの子が残っているメッシュがあればtrue
+		bool hasLazyObjects() const noexcept;
+
 		std::vector<XFileMesh> meshes;
+		XFileFrameTable frames;
+		std::vector<XFileAnimationSet> animationSets;
 	};
 }
 
@@ -0,0 +1,46 @@
+#include "XFileAllocationCounter.h"
+
+namespace xfile
+{
+	XFileAllocationCounter::XFileAllocationCounter(std::pmr::memory_resource * p_upstream)
+		: mpUpstream(p_upstream)
+	{
+	}
+
+	void XFileAllocationCounter::reset() noexcept
+	{
+		mAllocationCount = 0;
+		mDeallocationCount = 0;
+		mAllocatedBytes = 0;
+		mPeakBytes = mCurrentBytes.load();
+	}
+
+	void * XFileAllocationCounter::do_allocate(size_t bytes, size_t alignment)
+	{
+		void * p = mpUpstream->allocate(bytes, alignment);
+
+		++mAllocationCount;
+		mAllocatedBytes += bytes;
+
+		size_t current = mCurrentBytes += bytes;
+		size_t peak = mPeakBytes;
+		while(peak < current && !mPeakBytes.compare_exchange_weak(peak, current))
+		{
+		}
+
+		return p;
+	}
+
+	void XFileAllocationCounter::do_deallocate(void * p, size_t bytes, size_t alignment)
+	{
+		mpUpstream->deallocate(p, bytes, alignment);
+
+		++mDeallocationCount;
+		mCurrentBytes -= bytes;
+	}
+
+	bool XFileAllocationCounter::do_is_equal(const std::pmr::memory_resource & other) const noexcept
+	{
+		return this == &other;
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+#ifndef XFILE_XFILE_ALLOCATION_COUNTER_H_INCLUDED
+#define XFILE_XFILE_ALLOCATION_COUNTER_H_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+
+namespace xfile
+{
+	// 上流のメモリリソースへの確保と解放の回数を数える
+	class XFileAllocationCounter : public std::pmr::memory_resource
+	{
+	public:
+		XFileAllocationCounter(std::pmr::memory_resource * p_upstream = std::pmr::get_default_resource());
+
+		size_t allocationCount() const noexcept { return mAllocationCount; }
+		size_t deallocationCount() const noexcept { return mDeallocationCount; }
+		size_t allocatedBytes() const noexcept { return mAllocatedBytes; }
+		size_t peakBytes() const noexcept { return mPeakBytes; }
+
+		void reset() noexcept;
+
+	private:
+		void * do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void * p, size_t bytes, size_t alignment) override;
+		bool do_is_equal(const std::pmr::memory_resource & other) const noexcept override;
+
+	private:
+		std::pmr::memory_resource * mpUpstream;
+		std::atomic<size_t> mAllocationCount = 0;
+		std::atomic<size_t> mDeallocationCount = 0;
+		std::atomic<size_t> mAllocatedBytes = 0;
+		std::atomic<size_t> mCurrentBytes = 0;
+		std::atomic<size_t> mPeakBytes = 0;
+	};
+}
+
+#endif // XFILE_XFILE_ALLOCATION_COUNTER_H_INCLUDED
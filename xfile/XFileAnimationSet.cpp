@@ -0,0 +1,320 @@
+#include "XFileAnimationSet.h"
+#include <cmath>
+#include <unordered_map>
+#include "XFileDataCursor.h"
+
+namespace
+{
+	uint32_t toValueCount(xfile::XFileAnimationKeyType key_type)
+	{
+		switch(key_type)
+		{
+		case xfile::XFileAnimationKeyType::Rotation:
+			return 4;
+		case xfile::XFileAnimationKeyType::Scale:
+		case xfile::XFileAnimationKeyType::Position:
+			return 3;
+		case xfile::XFileAnimationKeyType::Matrix:
+			return 16;
+		default:
+			return 0;
+		}
+	}
+
+	// time以下で最後のキーを探す．分岐しない二分探索なので，
+	// チャンネルごとにキーの数が違っても予測ミスが起きない
+	uint32_t findKey(const float * p_times, uint32_t key_count, float time) noexcept
+	{
+		const float * p = p_times;
+		uint32_t n = key_count;
+		while(n > 1)
+		{
+			uint32_t half = n / 2;
+			p = p[half] <= time ? p + half : p;
+			n -= half;
+		}
+
+		return static_cast<uint32_t>(p - p_times);
+	}
+
+	void lerp(const float * p_a, const float * p_b, float t, float * p_output, uint32_t count) noexcept
+	{
+		for(uint32_t i = 0; i < count; ++i)
+		{
+			p_output[i] = p_a[i] + (p_b[i] - p_a[i]) * t;
+		}
+	}
+
+	// 回転のチャンネルは，キーを探す間にこの数ずつ成分ごとの配列へ集めてからまとめて補間する
+	constexpr size_t RotationBatchSize = 64;
+
+	struct RotationBatch
+	{
+		float ax[RotationBatchSize];
+		float ay[RotationBatchSize];
+		float az[RotationBatchSize];
+		float aw[RotationBatchSize];
+		float bx[RotationBatchSize];
+		float by[RotationBatchSize];
+		float bz[RotationBatchSize];
+		float bw[RotationBatchSize];
+		float t[RotationBatchSize];
+		float * pOutputs[RotationBatchSize];
+		size_t count = 0;
+	};
+
+	// acosとsinを使わずに，nlerpの補間の割合を3次式で補正してslerpに近づける
+	// 分岐がないのでループがベクトル化しやすい．slerpとの角度の差は1e-3ラジアン未満
+	void slerpBatch(RotationBatch & batch) noexcept
+	{
+		float qx[RotationBatchSize];
+		float qy[RotationBatchSize];
+		float qz[RotationBatchSize];
+		float qw[RotationBatchSize];
+
+		const size_t count = batch.count;
+		for(size_t i = 0; i < count; ++i)
+		{
+			float dot = batch.ax[i] * batch.bx[i] + batch.ay[i] * batch.by[i] + batch.az[i] * batch.bz[i] + batch.aw[i] * batch.bw[i];
+
+			// 遠回りしないように，反対を向いていれば片方を反転する
+			float sign = dot < 0.0f ? -1.0f : 1.0f;
+			float d = dot * sign;
+
+			float t = batch.t[i];
+			float a = 1.0904f + d * (-3.2452f + d * (3.55645f - d * 1.43519f));
+			float b = 0.848013f + d * (-1.06021f + d * 0.215638f);
+			float k = a * (t - 0.5f) * (t - 0.5f) + b;
+			float corrected = t + t * (t - 0.5f) * (t - 1.0f) * k;
+
+			float wa = 1.0f - corrected;
+			float wb = corrected * sign;
+			qx[i] = batch.ax[i] * wa + batch.bx[i] * wb;
+			qy[i] = batch.ay[i] * wa + batch.by[i] * wb;
+			qz[i] = batch.az[i] * wa + batch.bz[i] * wb;
+			qw[i] = batch.aw[i] * wa + batch.bw[i] * wb;
+
+			float inverse_length = 1.0f / std::sqrt(qx[i] * qx[i] + qy[i] * qy[i] + qz[i] * qz[i] + qw[i] * qw[i]);
+			qx[i] *= inverse_length;
+			qy[i] *= inverse_length;
+			qz[i] *= inverse_length;
+			qw[i] *= inverse_length;
+		}
+
+		for(size_t i = 0; i < count; ++i)
+		{
+			float * p_output = batch.pOutputs[i];
+			p_output[0] = qx[i];
+			p_output[1] = qy[i];
+			p_output[2] = qz[i];
+			p_output[3] = qw[i];
+		}
+
+		batch.count = 0;
+	}
+
+	void addRotation(RotationBatch & batch, const float * p_a, const float * p_b, float t, float * p_output) noexcept
+	{
+		size_t i = batch.count++;
+		batch.ax[i] = p_a[0];
+		batch.ay[i] = p_a[1];
+		batch.az[i] = p_a[2];
+		batch.aw[i] = p_a[3];
+		batch.bx[i] = p_b[0];
+		batch.by[i] = p_b[1];
+		batch.bz[i] = p_b[2];
+		batch.bw[i] = p_b[3];
+		batch.t[i] = t;
+		batch.pOutputs[i] = p_output;
+
+		if(batch.count == RotationBatchSize)
+		{
+			slerpBatch(batch);
+		}
+	}
+}
+
+namespace xfile
+{
+	bool XFileAnimationSet::setup(const XFileObject & object)
+	{
+		if(object.name.compare("AnimationSet") != 0)
+		{
+			return false;
+		}
+
+		name = object.optionalName;
+
+		for(const auto & data : object.dataArray)
+		{
+			auto p_child = data.object();
+			if(p_child == nullptr || p_child->name.compare("Animation") != 0)
+			{
+				continue;
+			}
+
+			if(!setupAnimation(*p_child))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool XFileAnimationSet::setupAnimation(const XFileObject & object)
+	{
+		// 対象のフレームは{ name }で参照するのが普通だが，Frameを直接書いてもよい
+		std::string frame_name;
+		for(const auto & data : object.dataArray)
+		{
+			if(data.dataType == DataType::Reference)
+			{
+				frame_name = data.reference();
+			}
+			else if(data.object() != nullptr && data.object()->name.compare("Frame") == 0)
+			{
+				frame_name = data.object()->optionalName;
+			}
+		}
+
+		for(const auto & data : object.dataArray)
+		{
+			auto p_child = data.object();
+			if(p_child == nullptr || p_child->name.compare("AnimationKey") != 0)
+			{
+				continue;
+			}
+
+			if(!setupAnimationKey(*p_child, frame_name))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool XFileAnimationSet::setupAnimationKey(const XFileObject & object, const std::string & frame_name)
+	{
+		XFileDataCursor cursor(object.dataArray);
+
+		uint32_t key_type;
+		uint32_t key_count;
+		if(!cursor.readInteger(key_type) || !cursor.readInteger(key_count))
+		{
+			return false;
+		}
+
+		XFileAnimationChannel channel
+		{
+			.frameName = frame_name,
+			.keyType = static_cast<XFileAnimationKeyType>(key_type),
+			.firstKey = static_cast<uint32_t>(times.size()),
+			.keyCount = key_count,
+			.firstValue = static_cast<uint32_t>(values.size()),
+			.valueCount = toValueCount(static_cast<XFileAnimationKeyType>(key_type)),
+			.outputOffset = outputSize,
+		};
+
+		if(channel.valueCount == 0 || key_count == 0)
+		{
+			return false;
+		}
+
+		times.reserve(times.size() + key_count);
+		values.reserve(values.size() + static_cast<size_t>(key_count) * channel.valueCount);
+
+		for(uint32_t i = 0; i < key_count; ++i)
+		{
+			uint32_t time;
+			uint32_t value_count;
+			if(!cursor.readInteger(time) || !cursor.readInteger(value_count))
+			{
+				return false;
+			}
+
+			if(value_count != channel.valueCount)
+			{
+				return false;
+			}
+
+			float key_values[16];
+			if(!cursor.readFloats(key_values, value_count))
+			{
+				return false;
+			}
+
+			// ファイルでは回転を(w, x, y, z)の順に並べている
+			if(channel.keyType == XFileAnimationKeyType::Rotation)
+			{
+				float w = key_values[0];
+				key_values[0] = key_values[1];
+				key_values[1] = key_values[2];
+				key_values[2] = key_values[3];
+				key_values[3] = w;
+			}
+
+			times.emplace_back(static_cast<float>(time));
+			values.insert(values.end(), key_values, key_values + value_count);
+		}
+
+		outputSize += channel.valueCount;
+		channels.emplace_back(std::move(channel));
+
+		return true;
+	}
+
+	void XFileAnimationSet::bind(const XFileFrameTable & frames)
+	{
+		std::unordered_map<std::string_view, uint32_t> indices;
+		indices.reserve(frames.size());
+		for(size_t i = 0; i < frames.size(); ++i)
+		{
+			indices.emplace(frames.names[i], static_cast<uint32_t>(i));
+		}
+
+		for(auto & channel : channels)
+		{
+			auto it = indices.find(channel.frameName);
+			channel.frameIndex = it != indices.end() ? it->second : XFileFrameTable::NoParent;
+		}
+	}
+
+	void XFileAnimationSet::sample(float time, std::span<float> output) const noexcept
+	{
+		if(output.size() < outputSize)
+		{
+			return;
+		}
+
+		RotationBatch rotations;
+		for(const auto & channel : channels)
+		{
+			const float * p_times = times.data() + channel.firstKey;
+			const float * p_values = values.data() + channel.firstValue;
+
+			uint32_t key = findKey(p_times, channel.keyCount, time);
+			uint32_t next_key = key + 1 < channel.keyCount ? key + 1 : key;
+
+			float span = p_times[next_key] - p_times[key];
+			float t = span > 0.0f ? (time - p_times[key]) / span : 0.0f;
+			t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+
+			const float * p_a = p_values + key * channel.valueCount;
+			const float * p_b = p_values + next_key * channel.valueCount;
+			float * p_output = output.data() + channel.outputOffset;
+
+			if(channel.keyType == XFileAnimationKeyType::Rotation)
+			{
+				addRotation(rotations, p_a, p_b, t, p_output);
+			}
+			else
+			{
+				lerp(p_a, p_b, t, p_output, channel.valueCount);
+			}
+		}
+
+		slerpBatch(rotations);
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+#ifndef XFILE_XFILE_ANIMATION_SET_H_INCLUDED
+#define XFILE_XFILE_ANIMATION_SET_H_INCLUDED
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include "XFileObject.h"
+#include "XFileFrameTable.h"
+
+namespace xfile
+{
+	enum class XFileAnimationKeyType : uint32_t
+	{
+		Rotation = 0,
+		Scale = 1,
+		Position = 2,
+		Matrix = 4,
+	};
+
+	// AnimationKey 1つ分．キーの時刻と値はXFileAnimationSetの配列に連続して並ぶ
+	struct XFileAnimationChannel
+	{
+		std::string frameName;
+		uint32_t frameIndex = XFileFrameTable::NoParent;
+		XFileAnimationKeyType keyType = XFileAnimationKeyType::Rotation;
+
+		uint32_t firstKey = 0;
+		uint32_t keyCount = 0;
+
+		// 1キーあたりの値の数．回転は(x, y, z, w)の4，拡大と移動は3，行列は16
+		uint32_t firstValue = 0;
+		uint32_t valueCount = 0;
+
+		// sampleの出力先での位置
+		uint32_t outputOffset = 0;
+	};
+
+	struct XFileAnimationSet
+	{
+		bool setup(const XFileObject & object);
+
+		// channelsのframeIndexをframesの番号に合わせる
+		void bind(const XFileFrameTable & frames);
+
+		// 各チャンネルの時刻timeでの値をoutputのoutputOffsetの位置に書き込む
+		// 範囲外の時刻は最初か最後のキーの値になる
+		// 回転は全チャンネル分を成分ごとの配列に集め，nlerpを補正した近似のslerpでまとめて補間する
+		void sample(float time, std::span<float> output) const noexcept;
+
+		std::string name;
+		std::vector<XFileAnimationChannel> channels;
+		std::vector<float> times;
+		std::vector<float> values;
+		uint32_t outputSize = 0;
+
+	private:
+		bool setupAnimation(const XFileObject & object);
+		bool setupAnimationKey(const XFileObject & object, const std::string & frame_name);
+	};
+}
+
+#endif // XFILE_XFILE_ANIMATION_SET_H_INCLUDED
@@ -0,0 +1,32 @@
+#include "XFileAsyncLoad.h"
+#include <chrono>
+#include "XFileBatchLoader.h"
+
+namespace xfile
+{
+	XFileAsyncLoad::XFileAsyncLoad(std::string path)
+	{
+		std::promise<XFileLoadResult> promise;
+		mResult = promise.get_future();
+
+		mThread = std::jthread([this, path = std::move(path), promise = std::move(promise)](std::stop_token stop_token) mutable
+		{
+			promise.set_value(XFileBatchLoader::loadFile(path, stop_token, &mProgress));
+		});
+	}
+
+	void XFileAsyncLoad::cancel()
+	{
+		mThread.request_stop();
+	}
+
+	bool XFileAsyncLoad::isReady() const
+	{
+		return mResult.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+
+	XFileLoadResult XFileAsyncLoad::get()
+	{
+		return mResult.get();
+	}
+}
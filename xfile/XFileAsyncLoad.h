@@ -0,0 +1,41 @@
+#pragma once
+#ifndef XFILE_XFILE_ASYNC_LOAD_H_INCLUDED
+#define XFILE_XFILE_ASYNC_LOAD_H_INCLUDED
+
+#include <future>
+#include <string>
+#include <thread>
+#include "XFileLoadProgress.h"
+#include "XFileLoadResult.h"
+
+namespace xfile
+{
+	// 1つの.xファイルを専用のスレッドで読み込む
+	// 読み込み中もprogressで進み具合を確認でき，cancelで途中で打ち切れる
+	// 破棄すると読み込みを打ち切ってスレッドの終了を待つ
+	class XFileAsyncLoad
+	{
+	public:
+		XFileAsyncLoad(std::string path);
+
+		XFileAsyncLoad(const XFileAsyncLoad &) = delete;
+		XFileAsyncLoad & operator=(const XFileAsyncLoad &) = delete;
+
+		void cancel();
+		bool isReady() const;
+
+		// 読み込みが終わるまで待ってから結果を返す．呼べるのは1回だけ
+		XFileLoadResult get();
+
+		const XFileLoadProgress & progress() const noexcept { return mProgress; }
+
+	private:
+		XFileLoadProgress mProgress;
+		std::future<XFileLoadResult> mResult;
+
+		// スレッドはほかのメンバーを参照するので，最初に破棄されるよう最後に置く
+		std::jthread mThread;
+	};
+}
+
+#endif // XFILE_XFILE_ASYNC_LOAD_H_INCLUDED
@@ -0,0 +1,112 @@
+#include "XFileBatchLoader.h"
+#include <atomic>
+#include <memory>
+#include "XFileReader.h"
+
+namespace xfile
+{
+	XFileBatchLoader::XFileBatchLoader(size_t thread_count)
+		: mThreadPool(thread_count)
+	{
+	}
+
+	std::vector<std::future<XFileLoadResult>> XFileBatchLoader::load(std::span<const std::string> paths)
+	{
+		std::vector<std::future<XFileLoadResult>> results;
+		results.reserve(paths.size());
+
+		for(const auto & path : paths)
+		{
+			results.emplace_back(mThreadPool.submit([path] { return loadFile(path); }));
+		}
+
+		return results;
+	}
+
+	std::future<void> XFileBatchLoader::load(
+		std::span<const std::string> paths,
+		std::function<void(XFileLoadResult &&)> on_loaded
+	)
+	{
+		struct Batch
+		{
+			std::function<void(XFileLoadResult &&)> onLoaded;
+			std::atomic<size_t> remaining;
+			std::promise<void> completed;
+
+			// 最初に投げられた例外だけを残し，すべて終わった後にfutureへ渡す
+			std::atomic<bool> failed;
+			std::exception_ptr exception;
+		};
+
+		auto p_batch = std::make_shared<Batch>();
+		p_batch->onLoaded = std::move(on_loaded);
+		p_batch->remaining = paths.size();
+		p_batch->failed = false;
+
+		auto completed = p_batch->completed.get_future();
+		if(paths.empty())
+		{
+			p_batch->completed.set_value();
+			return completed;
+		}
+
+		for(const auto & path : paths)
+		{
+			mThreadPool.submit([p_batch, path]
+			{
+				// 例外で抜けると残りの数が減らず，futureが準備完了にならないので，ここで受け止める
+				try
+				{
+					p_batch->onLoaded(loadFile(path));
+				}
+				catch(...)
+				{
+					if(!p_batch->failed.exchange(true))
+					{
+						p_batch->exception = std::current_exception();
+					}
+				}
+
+				if(--p_batch->remaining == 0)
+				{
+					if(p_batch->exception)
+					{
+						p_batch->completed.set_exception(p_batch->exception);
+					}
+					else
+					{
+						p_batch->completed.set_value();
+					}
+				}
+			});
+		}
+
+		return completed;
+	}
+
+	XFileLoadResult XFileBatchLoader::loadFile(
+		const std::string & path,
+		std::stop_token stop_token,
+		XFileLoadProgress * p_progress
+	)
+	{
+		XFileLoadResult result;
+		result.path = path;
+
+		XFileReader reader;
+		if(!reader.open(path.c_str()))
+		{
+			return result;
+		}
+
+		reader.setStopToken(stop_token);
+		reader.setProgress(p_progress);
+
+		result.succeeded = reader.read(result.xfile);
+		result.cancelled = !result.succeeded && stop_token.stop_requested();
+		reader.close();
+
+		return result;
+	}
+}
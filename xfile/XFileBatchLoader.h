@@ -0,0 +1,45 @@
+#pragma once
+#ifndef XFILE_XFILE_BATCH_LOADER_H_INCLUDED
+#define XFILE_XFILE_BATCH_LOADER_H_INCLUDED
+
+#include <functional>
+#include <future>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <vector>
+#include "XFileLoadProgress.h"
+#include "XFileLoadResult.h"
+#include "XFileThreadPool.h"
+
+namespace xfile
+{
+	// 複数の.xファイルをスレッドプールで並列に読み込む
+	// ファイルごとに独立したXFileReaderを使うので，タスク間で共有する状態はない
+	class XFileBatchLoader
+	{
+	public:
+		XFileBatchLoader(size_t thread_count = std::thread::hardware_concurrency());
+
+		std::vector<std::future<XFileLoadResult>> load(std::span<const std::string> paths);
+
+		// on_loadedは読み込みが終わった順にワーカースレッドから呼ばれる
+		// 戻り値のfutureはすべてのファイルの通知が終わると準備完了になる
+		// on_loadedが例外を投げても残りのファイルは通知し，最初の例外をfutureから投げ直す
+		std::future<void> load(
+			std::span<const std::string> paths,
+			std::function<void(XFileLoadResult &&)> on_loaded
+		);
+
+		static XFileLoadResult loadFile(
+			const std::string & path,
+			std::stop_token stop_token = {},
+			XFileLoadProgress * p_progress = nullptr
+		);
+
+	private:
+		XFileThreadPool mThreadPool;
+	};
+}
+
+#endif // XFILE_XFILE_BATCH_LOADER_H_INCLUDED
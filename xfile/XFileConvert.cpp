@@ -0,0 +1,50 @@
+#include "XFileConvert.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define XFILE_USE_AVX 1
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define XFILE_USE_SSE2 1
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#include <arm_neon.h>
+#define XFILE_USE_NEON 1
+#endif
+
+namespace xfile
+{
+	void convertDoubleToFloat(const double * p_src, float * p_dst, size_t count) noexcept
+	{
+		size_t i = 0;
+
+#if XFILE_USE_AVX
+		// /arch:AVXや/arch:AVX2では256ビットのレジスタで4要素ずつ変換し，2回分の8要素をまとめて書き込む
+		for(; i + 8 <= count; i += 8)
+		{
+			__m128 low = _mm256_cvtpd_ps(_mm256_loadu_pd(p_src + i));
+			__m128 high = _mm256_cvtpd_ps(_mm256_loadu_pd(p_src + i + 4));
+			_mm_storeu_ps(p_dst + i, low);
+			_mm_storeu_ps(p_dst + i + 4, high);
+		}
+#elif XFILE_USE_SSE2
+		for(; i + 4 <= count; i += 4)
+		{
+			__m128 low = _mm_cvtpd_ps(_mm_loadu_pd(p_src + i));
+			__m128 high = _mm_cvtpd_ps(_mm_loadu_pd(p_src + i + 2));
+			_mm_storeu_ps(p_dst + i, _mm_movelh_ps(low, high));
+		}
+#elif XFILE_USE_NEON
+		for(; i + 4 <= count; i += 4)
+		{
+			float32x2_t low = vcvt_f32_f64(vld1q_f64(p_src + i));
+			float32x4_t values = vcvt_high_f32_f64(low, vld1q_f64(p_src + i + 2));
+			vst1q_f32(p_dst + i, values);
+		}
+#endif
+
+		for(; i < count; ++i)
+		{
+			p_dst[i] = static_cast<float>(p_src[i]);
+		}
+	}
+}
@@ -0,0 +1,14 @@
+#pragma once
+#ifndef XFILE_XFILE_CONVERT_H_INCLUDED
+#define XFILE_XFILE_CONVERT_H_INCLUDED
+
+#include <cstddef>
+
+namespace xfile
+{
+	// 64ビットの浮動小数点数のリストを32ビットに変換する
+	// p_srcはバイナリ形式の入力を直接指すことがあるのでアラインされていなくてもよい
+	void convertDoubleToFloat(const double * p_src, float * p_dst, size_t count) noexcept;
+}
+
+#endif // XFILE_XFILE_CONVERT_H_INCLUDED
@@ -0,0 +1,68 @@
+#pragma once
+#ifndef XFILE_XFILE_COOKED_FORMAT_H_INCLUDED
+#define XFILE_XFILE_COOKED_FORMAT_H_INCLUDED
+
+#include <cstdint>
+
+namespace xfile
+{
+	// 描画用に変換済みのメッシュのファイル形式
+	// ヘッダの後ろに頂点，インデックス，描画範囲，マテリアル，文字列の順で
+	// 16バイト境界に揃えて並べる．位置はヘッダからのオフセットで持ち，読み込み時にポインタへ直す
+	struct XFileCookedHeader
+	{
+		static constexpr uint32_t Magic = 'x' | ('c' << 8) | ('k' << 16) | ('d' << 24);
+		static constexpr uint32_t Version = 2;
+		static constexpr uint32_t SectionAlignment = 16;
+
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vertexStride;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t drawRangeCount;
+		uint32_t materialCount;
+		uint32_t stringSize;
+		uint64_t vertexOffset;
+		uint64_t indexOffset;
+		uint64_t drawRangeOffset;
+		uint64_t materialOffset;
+		uint64_t stringOffset;
+		float boundsMin[3];
+		float boundsMax[3];
+	};
+
+	// GPUDeviceD3D11の頂点と同じ並び
+	struct XFileCookedVertex
+	{
+		float position[3];
+		float normal[3];
+		float uv[2];
+	};
+
+	// 同じマテリアルで描く三角形の範囲
+	struct XFileCookedDrawRange
+	{
+		static constexpr uint32_t NoMaterial = UINT32_MAX;
+
+		uint32_t indexStart;
+		uint32_t indexCount;
+		uint32_t materialIndex;
+		uint32_t meshIndex;
+	};
+
+	struct XFileCookedMaterial
+	{
+		float faceColor[4];
+		float power;
+		float specularColor[3];
+		float emissiveColor[3];
+
+		// 文字列の領域での位置．テクスチャが無ければtextureFilenameSizeは0
+		// 文字列は終端の'\0'を含めて格納する
+		uint32_t textureFilenameOffset;
+		uint32_t textureFilenameSize;
+	};
+}
+
+#endif // XFILE_XFILE_COOKED_FORMAT_H_INCLUDED
@@ -0,0 +1,430 @@
+#include "XFileCookedMesh.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <fstream>
+#include "XFileVertexCache.h"
+#include "XFileVertexWelding.h"
+
+namespace
+{
+	uint32_t findFaceMaterial(const xfile::XFileMeshMaterialList & material_list, size_t face_index)
+	{
+		if(material_list.materials.empty() || material_list.faceIndexes.empty())
+		{
+			return 0;
+		}
+
+		// 面の数より少なければ最後のマテリアルを繰り返す
+		return material_list.faceIndexes[std::min(face_index, material_list.faceIndexes.size() - 1)];
+	}
+
+	uint64_t appendSection(std::vector<std::byte> & bytes, const void * p_data, size_t size)
+	{
+		constexpr size_t alignment = xfile::XFileCookedHeader::SectionAlignment;
+		bytes.resize((bytes.size() + alignment - 1) / alignment * alignment);
+
+		auto offset = static_cast<uint64_t>(bytes.size());
+		auto p_bytes = static_cast<const std::byte *>(p_data);
+		bytes.insert(bytes.end(), p_bytes, p_bytes + size);
+
+		return offset;
+	}
+
+	// 描画範囲ごとに，メッシュの頂点の番号に戻してから並べ替える
+	bool optimizeDrawRange(std::span<uint32_t> indices, uint32_t base_vertex, size_t vertex_count)
+	{
+		for(auto & index : indices)
+		{
+			index -= base_vertex;
+		}
+
+		if(!xfile::optimizeVertexCache(indices, vertex_count))
+		{
+			return false;
+		}
+
+		for(auto & index : indices)
+		{
+			index += base_vertex;
+		}
+
+		return true;
+	}
+
+	void simulateVertexCaches(std::span<const uint32_t> indices, size_t vertex_count, xfile::XFileVertexCacheStats & fifo, xfile::XFileVertexCacheStats & lru)
+	{
+		using Stats = xfile::XFileCookedMeshStats;
+		fifo = xfile::simulateVertexCache(indices, vertex_count, xfile::XFileVertexCacheKind::Fifo, Stats::FifoCacheSize);
+		lru = xfile::simulateVertexCache(indices, vertex_count, xfile::XFileVertexCacheKind::Lru, Stats::LruCacheSize);
+	}
+}
+
+namespace xfile
+{
+	bool XFileCookedMesh::cook(const XFile & xfile, std::vector<std::byte> & bytes, XFileCookedMeshStats * p_stats)
+	{
+		if(xfile.hasLazyObjects())
+		{
+			return false;
+		}
+
+		std::vector<XFileCookedVertex> vertices;
+		std::vector<uint32_t> indices;
+		std::vector<XFileCookedDrawRange> draw_ranges;
+		std::vector<XFileCookedMaterial> materials;
+		std::vector<char> strings;
+
+		XFileCookedHeader header
+		{
+			.magic = XFileCookedHeader::Magic,
+			.version = XFileCookedHeader::Version,
+			.vertexStride = sizeof(XFileCookedVertex),
+
+			// 数と位置は各セクションを並べた後で埋める
+			.vertexCount = 0,
+			.indexCount = 0,
+			.drawRangeCount = 0,
+			.materialCount = 0,
+			.stringSize = 0,
+			.vertexOffset = 0,
+			.indexOffset = 0,
+			.drawRangeOffset = 0,
+			.materialOffset = 0,
+			.stringOffset = 0,
+			.boundsMin = { FLT_MAX, FLT_MAX, FLT_MAX },
+			.boundsMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX },
+		};
+
+		// 位置と法線の番号の組ごとに頂点を作る
+		std::vector<XFileVertexWelding> weldings(xfile.meshes.size());
+		std::vector<uint32_t> base_vertices(xfile.meshes.size());
+		size_t total_vertex_count = 0;
+		for(size_t mesh_index = 0; mesh_index < xfile.meshes.size(); ++mesh_index)
+		{
+			if(!weldings[mesh_index].setup(xfile.meshes[mesh_index]))
+			{
+				return false;
+			}
+			total_vertex_count += weldings[mesh_index].vertexCount();
+		}
+
+		if(total_vertex_count > UINT32_MAX)
+		{
+			return false;
+		}
+		vertices.reserve(total_vertex_count);
+
+		for(uint32_t mesh_index = 0; mesh_index < xfile.meshes.size(); ++mesh_index)
+		{
+			const auto & mesh = xfile.meshes[mesh_index];
+			const auto & welding = weldings[mesh_index];
+			auto base_vertex = static_cast<uint32_t>(vertices.size());
+			base_vertices[mesh_index] = base_vertex;
+
+			// テクスチャ座標は頂点と同じ番号で引けるときだけ使う
+			const auto & texture_coords = mesh.textureCoords.textureCoords;
+			bool has_uv = texture_coords.size() == mesh.vertices.size();
+			bool has_normals = welding.hasNormals;
+			for(size_t i = 0; i < welding.vertexCount(); ++i)
+			{
+				auto position_index = welding.sourceIndex(i, XFileVertexWelding::PositionStream);
+				const auto & v = mesh.vertices[position_index];
+				XFileCookedVertex vertex
+				{
+					.position = { v.x, v.y, v.z },
+					.normal = { 0.0f, 0.0f, 0.0f },
+					.uv = { has_uv ? texture_coords[position_index].u : 0.0f, has_uv ? texture_coords[position_index].v : 0.0f }
+				};
+
+				if(has_normals)
+				{
+					const auto & n = mesh.normals.normals[welding.sourceIndex(i, XFileVertexWelding::NormalStream)];
+					vertex.normal[0] = n.x;
+					vertex.normal[1] = n.y;
+					vertex.normal[2] = n.z;
+				}
+
+				vertices.emplace_back(vertex);
+
+				for(size_t c = 0; c < 3; ++c)
+				{
+					header.boundsMin[c] = std::min(header.boundsMin[c], vertex.position[c]);
+					header.boundsMax[c] = std::max(header.boundsMax[c], vertex.position[c]);
+				}
+			}
+
+			auto material_base = static_cast<uint32_t>(materials.size());
+			for(const auto & material : mesh.materialList.materials)
+			{
+				XFileCookedMaterial cooked_material
+				{
+					.faceColor = { material.faceColor.red, material.faceColor.green, material.faceColor.blue, material.faceColor.alpha },
+					.power = material.power,
+					.specularColor = { material.specularColor.red, material.specularColor.green, material.specularColor.blue },
+					.emissiveColor = { material.emissiveColor.red, material.emissiveColor.green, material.emissiveColor.blue },
+					.textureFilenameOffset = static_cast<uint32_t>(strings.size()),
+					.textureFilenameSize = 0
+				};
+
+				const auto & filename = material.textureFilename.filename;
+				if(!filename.empty())
+				{
+					cooked_material.textureFilenameSize = static_cast<uint32_t>(filename.size() + 1);
+					strings.insert(strings.end(), filename.c_str(), filename.c_str() + filename.size() + 1);
+				}
+
+				materials.emplace_back(cooked_material);
+			}
+
+			// マテリアルごとの三角形の数を数えてから，それぞれの範囲へ振り分ける
+			size_t material_count = std::max<size_t>(mesh.materialList.materials.size(), 1);
+			std::vector<size_t> cursors(material_count, 0);
+			for(size_t f = 0; f < mesh.faceCount(); ++f)
+			{
+				auto material_index = findFaceMaterial(mesh.materialList, f);
+				if(material_index >= material_count)
+				{
+					return false;
+				}
+
+				cursors[material_index] += 3;
+			}
+
+			size_t start = indices.size();
+			for(uint32_t m = 0; m < material_count; ++m)
+			{
+				size_t count = cursors[m];
+				if(count > 0)
+				{
+					XFileCookedDrawRange draw_range
+					{
+						.indexStart = static_cast<uint32_t>(start),
+						.indexCount = static_cast<uint32_t>(count),
+						.materialIndex = mesh.materialList.materials.empty() ? XFileCookedDrawRange::NoMaterial : material_base + m,
+						.meshIndex = mesh_index
+					};
+					draw_ranges.emplace_back(draw_range);
+				}
+
+				cursors[m] = start;
+				start += count;
+			}
+
+			if(start > UINT32_MAX)
+			{
+				return false;
+			}
+			indices.resize(start);
+
+			for(size_t f = 0; f < mesh.faceCount(); ++f)
+			{
+				auto & cursor = cursors[findFaceMaterial(mesh.materialList, f)];
+				for(size_t i = f * 3; i < f * 3 + 3; ++i)
+				{
+					indices[cursor++] = base_vertex + welding.indices[i];
+				}
+			}
+		}
+
+		// 面の並びは作ったときの順番のままなので，頂点キャッシュに合わせて並べ替える
+		if(p_stats != nullptr)
+		{
+			simulateVertexCaches(indices, vertices.size(), p_stats->fifoBefore, p_stats->lruBefore);
+		}
+
+		for(const auto & draw_range : draw_ranges)
+		{
+			auto range = std::span(indices).subspan(draw_range.indexStart, draw_range.indexCount);
+			if(!optimizeDrawRange(range, base_vertices[draw_range.meshIndex], weldings[draw_range.meshIndex].vertexCount()))
+			{
+				return false;
+			}
+		}
+
+		if(p_stats != nullptr)
+		{
+			simulateVertexCaches(indices, vertices.size(), p_stats->fifoAfter, p_stats->lruAfter);
+		}
+
+		if(vertices.empty())
+		{
+			std::fill(std::begin(header.boundsMin), std::end(header.boundsMin), 0.0f);
+			std::fill(std::begin(header.boundsMax), std::end(header.boundsMax), 0.0f);
+		}
+
+		header.vertexCount = static_cast<uint32_t>(vertices.size());
+		header.indexCount = static_cast<uint32_t>(indices.size());
+		header.drawRangeCount = static_cast<uint32_t>(draw_ranges.size());
+		header.materialCount = static_cast<uint32_t>(materials.size());
+		header.stringSize = static_cast<uint32_t>(strings.size());
+
+		bytes.clear();
+		bytes.reserve(sizeof(header) + (sizeof(XFileCookedVertex) * vertices.size()) + (sizeof(uint32_t) * indices.size()) + XFileCookedHeader::SectionAlignment * 5);
+		bytes.resize(sizeof(header));
+		header.vertexOffset = appendSection(bytes, vertices.data(), sizeof(XFileCookedVertex) * vertices.size());
+		header.indexOffset = appendSection(bytes, indices.data(), sizeof(uint32_t) * indices.size());
+		header.drawRangeOffset = appendSection(bytes, draw_ranges.data(), sizeof(XFileCookedDrawRange) * draw_ranges.size());
+		header.materialOffset = appendSection(bytes, materials.data(), sizeof(XFileCookedMaterial) * materials.size());
+		header.stringOffset = appendSection(bytes, strings.data(), strings.size());
+		memcpy(bytes.data(), &header, sizeof(header));
+
+		return true;
+	}
+
+	bool XFileCookedMesh::cook(const XFile & xfile, const char * p_file_path, XFileCookedMeshStats * p_stats)
+	{
+		std::vector<std::byte> bytes;
+		if(!cook(xfile, bytes, p_stats))
+		{
+			return false;
+		}
+
+		std::ofstream fout(p_file_path, std::ios::binary);
+		if(!fout)
+		{
+			return false;
+		}
+
+		fout.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+		return static_cast<bool>(fout);
+	}
+
+	bool XFileCookedMesh::open(const char * p_file_path)
+	{
+		close();
+
+		if(!mMappedFile.open(p_file_path))
+		{
+			return false;
+		}
+
+		if(!setup(mMappedFile.bytes()))
+		{
+			close();
+			return false;
+		}
+
+		return true;
+	}
+
+	bool XFileCookedMesh::open(std::span<const std::byte> bytes)
+	{
+		close();
+
+		if(!setup(bytes))
+		{
+			close();
+			return false;
+		}
+
+		return true;
+	}
+
+	bool XFileCookedMesh::close()
+	{
+		mBytes = {};
+		mpHeader = nullptr;
+		mVertices = {};
+		mIndices = {};
+		mDrawRanges = {};
+		mMaterials = {};
+		mStrings = {};
+
+		if(mMappedFile.isOpen())
+		{
+			return mMappedFile.close();
+		}
+
+		return true;
+	}
+
+	std::string_view XFileCookedMesh::textureFilename(const XFileCookedMaterial & material) const noexcept
+	{
+		if(material.textureFilenameSize == 0)
+		{
+			return {};
+		}
+
+		return { mStrings.data() + material.textureFilenameOffset, material.textureFilenameSize - 1 };
+	}
+
+	bool XFileCookedMesh::setup(std::span<const std::byte> bytes)
+	{
+		mBytes = bytes;
+
+		std::span<const XFileCookedHeader> header;
+		if(!fixup(0, 1, header))
+		{
+			return false;
+		}
+
+		const auto & h = header[0];
+		if(h.magic != XFileCookedHeader::Magic || h.version != XFileCookedHeader::Version || h.vertexStride != sizeof(XFileCookedVertex))
+		{
+			return false;
+		}
+
+		if(!fixup(h.vertexOffset, h.vertexCount, mVertices)
+			|| !fixup(h.indexOffset, h.indexCount, mIndices)
+			|| !fixup(h.drawRangeOffset, h.drawRangeCount, mDrawRanges)
+			|| !fixup(h.materialOffset, h.materialCount, mMaterials)
+			|| !fixup(h.stringOffset, h.stringSize, mStrings))
+		{
+			return false;
+		}
+
+		// インデックスの中身までは調べないが，範囲と文字列は壊れていても外へ出ないようにする
+		for(const auto & draw_range : mDrawRanges)
+		{
+			if(draw_range.indexStart > h.indexCount || draw_range.indexCount > h.indexCount - draw_range.indexStart)
+			{
+				return false;
+			}
+
+			if(draw_range.materialIndex != XFileCookedDrawRange::NoMaterial && draw_range.materialIndex >= h.materialCount)
+			{
+				return false;
+			}
+		}
+
+		for(const auto & material : mMaterials)
+		{
+			if(material.textureFilenameSize == 0)
+			{
+				continue;
+			}
+
+			if(material.textureFilenameOffset > h.stringSize
+				|| material.textureFilenameSize > h.stringSize - material.textureFilenameOffset
+				|| mStrings[material.textureFilenameOffset + material.textureFilenameSize - 1] != '\0')
+			{
+				return false;
+			}
+		}
+
+		mpHeader = &h;
+
+		return true;
+	}
+
+	template <class T>
+	bool XFileCookedMesh::fixup(uint64_t offset, size_t count, std::span<const T> & section)
+	{
+		if(offset > mBytes.size() || count > (mBytes.size() - offset) / sizeof(T))
+		{
+			return false;
+		}
+
+		auto p_section = mBytes.data() + offset;
+		if(reinterpret_cast<uintptr_t>(p_section) % alignof(T) != 0)
+		{
+			return false;
+		}
+
+		section = { reinterpret_cast<const T *>(p_section), count };
+
+		return true;
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+#ifndef XFILE_XFILE_COOKED_MESH_H_INCLUDED
+#define XFILE_XFILE_COOKED_MESH_H_INCLUDED
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "XFile.h"
+#include "XFileCookedFormat.h"
+#include "XFileMappedFile.h"
+#include "XFileVertexCache.h"
+
+namespace xfile
+{
+	// cookで三角形を並べ替える前と後の頂点キャッシュの効率
+	struct XFileCookedMeshStats
+	{
+		static constexpr size_t FifoCacheSize = 16;
+		static constexpr size_t LruCacheSize = 32;
+
+		XFileVertexCacheStats fifoBefore;
+		XFileVertexCacheStats fifoAfter;
+		XFileVertexCacheStats lruBefore;
+		XFileVertexCacheStats lruAfter;
+	};
+
+	// 変換済みのメッシュをマップしたまま参照する
+	// 返すspanはcloseするまで有効
+	class XFileCookedMesh
+	{
+	public:
+		// xfileの全メッシュを1つの頂点とインデックスの列にまとめる
+		// 頂点は位置と法線の組ごとに作り，三角形はメッシュとマテリアルごとに並べ替える
+		// 描画範囲の中の三角形は頂点キャッシュに合わせて並べ替える．p_statsを渡すとその前後の効率を書き込む
+		// 遅延読み込みの子が残っているメッシュがあればfalse．XFile::loadLazyObjectsを先に呼ぶ
+		static bool cook(const XFile & xfile, std::vector<std::byte> & bytes, XFileCookedMeshStats * p_stats = nullptr);
+		static bool cook(const XFile & xfile, const char * p_file_path, XFileCookedMeshStats * p_stats = nullptr);
+
+		bool open(const char * p_file_path);
+
+		// bytesは読み込みが終わるまで呼び出し側で保持する
+		// 各領域の先頭がアラインされている必要がある
+		bool open(std::span<const std::byte> bytes);
+		bool close();
+
+		bool isOpen() const noexcept { return mpHeader != nullptr; }
+
+		std::span<const XFileCookedVertex> vertices() const noexcept { return mVertices; }
+		std::span<const uint32_t> indices() const noexcept { return mIndices; }
+		std::span<const XFileCookedDrawRange> drawRanges() const noexcept { return mDrawRanges; }
+		std::span<const XFileCookedMaterial> materials() const noexcept { return mMaterials; }
+		std::string_view textureFilename(const XFileCookedMaterial & material) const noexcept;
+
+		const float * boundsMin() const noexcept { return mpHeader->boundsMin; }
+		const float * boundsMax() const noexcept { return mpHeader->boundsMax; }
+
+	private:
+		bool setup(std::span<const std::byte> bytes);
+
+		template <class T>
+		bool fixup(uint64_t offset, size_t count, std::span<const T> & section);
+
+	private:
+		XFileMappedFile mMappedFile;
+		std::span<const std::byte> mBytes;
+
+		const XFileCookedHeader * mpHeader = nullptr;
+		std::span<const XFileCookedVertex> mVertices;
+		std::span<const uint32_t> mIndices;
+		std::span<const XFileCookedDrawRange> mDrawRanges;
+		std::span<const XFileCookedMaterial> mMaterials;
+		std::span<const char> mStrings;
+	};
+}
+
+#endif // XFILE_XFILE_COOKED_MESH_H_INCLUDED
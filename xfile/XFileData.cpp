@@ -1 +1,32 @@
 #include "XFileData.h"
+#include <cstring>
+#include "XFileConvert.h"
+
+namespace xfile
+{
+	bool XFileData::copyFloatList(float * p_dst, size_t count) const noexcept
+	{
+		if(!isFloatList() || this->count != count)
+		{
+			return false;
+		}
+
+		if(dataType == DataType::Float)
+		{
+			memcpy(p_dst, pData, sizeof(float) * count);
+		}
+		else
+		{
+			// 揃っていないリストはdoubleListが空を返すので，ここで弾く
+			auto list = doubleList();
+			if(list.size() != count)
+			{
+				return false;
+			}
+
+			convertDoubleToFloat(list.data(), p_dst, count);
+		}
+
+		return true;
+	}
+}
@@ -3,32 +3,98 @@
 #define XFILE_XFILE_DATA_H_INCLUDED
 
 #include <cstdint>
-#include <string>
-#include <vector>
-#include <memory>
+#include <span>
+#include <string_view>
+#include "XFileLazyObject.h"
 
 namespace xfile
 {
 	struct XFileObject;
 
-	enum class DataType
+	enum class DataType : uint32_t
 	{
 		Integer,
 		Float,
 		Double,
 		String,
 		Object,
+		Reference,
+		Lazy,
 	};
 
+	// dataTypeに応じた要素の並びをpDataとcountで指す
+	// 指す先はXFileObjectBuilderのメモリリソースか，XFileListStorage::Referenceの場合はXFileReaderの入力にあるため，
+	// XFileDataそのものは何も所有しない
 	struct XFileData
 	{
 		DataType dataType;
-		std::vector<uint32_t> numberList;
-		std::vector<float> floatList;
-		std::vector<double> doubleList;
-		std::vector<std::string> stringList;
-		std::unique_ptr<XFileObject> object;
+		uint32_t count;
+		const void * pData;
+
+		std::span<const uint32_t> numberList() const noexcept
+		{
+			return view<uint32_t>(DataType::Integer);
+		}
+
+		std::span<const float> floatList() const noexcept
+		{
+			return view<float>(DataType::Float);
+		}
+
+		std::span<const double> doubleList() const noexcept
+		{
+			return view<double>(DataType::Double);
+		}
+
+		std::span<const std::string_view> stringList() const noexcept
+		{
+			return view<std::string_view>(DataType::String);
+		}
+
+		const XFileObject * object() const noexcept
+		{
+			return dataType == DataType::Object ? static_cast<const XFileObject *>(pData) : nullptr;
+		}
+
+		// {}で囲んで別のオブジェクトを名前で参照する
+		std::string_view reference() const noexcept
+		{
+			return dataType == DataType::Reference ? *static_cast<const std::string_view *>(pData) : std::string_view();
+		}
+
+		// 遅延読み込みで読み飛ばした子オブジェクト
+		const XFileLazyRange * lazyRange() const noexcept
+		{
+			return dataType == DataType::Lazy ? static_cast<const XFileLazyRange *>(pData) : nullptr;
+		}
+
+		// 浮動小数点数のリストはファイルによって32ビットか64ビットになるので，
+		// 読む側はどちらかを気にせずにこちらを使う
+		bool isFloatList() const noexcept
+		{
+			return dataType == DataType::Float || dataType == DataType::Double;
+		}
+
+		// 64ビットの場合はfloatに変換しながらp_dstへcount個コピーする
+		// 要素数が一致しない場合は何もせずにfalseを返す
+		bool copyFloatList(float * p_dst, size_t count) const noexcept;
+
+	private:
+		// リーダーもビルダーもリストを要素の境界に揃えて渡すので，通常は揃っている
+		// 揃っていないポインタからspanは作れないので，その場合は空のリストとして扱う
+		template <class T>
+		std::span<const T> view(DataType type) const noexcept
+		{
+			if(dataType != type || reinterpret_cast<uintptr_t>(pData) % alignof(T) != 0)
+			{
+				return {};
+			}
+
+			return { static_cast<const T *>(pData), count };
+		}
 	};
+
+	static_assert(sizeof(XFileData) <= 16);
 }
 
 #endif // XFILE_XFILE_DATA_H_INCLUDED
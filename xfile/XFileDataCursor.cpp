@@ -0,0 +1,91 @@
+#include "XFileDataCursor.h"
+#include <algorithm>
+#include <cstring>
+#include "XFileConvert.h"
+
+namespace xfile
+{
+	XFileDataCursor::XFileDataCursor(std::span<const XFileData> data_array)
+		: mDataArray(data_array)
+	{
+	}
+
+	bool XFileDataCursor::readInteger(uint32_t & value)
+	{
+		if(!seekNumberList() || mDataArray[mIndex].dataType != DataType::Integer)
+		{
+			return false;
+		}
+
+		value = mDataArray[mIndex].numberList()[mElement++];
+
+		return true;
+	}
+
+	bool XFileDataCursor::readFloats(float * p_values, size_t count)
+	{
+		while(count > 0)
+		{
+			if(!seekNumberList())
+			{
+				return false;
+			}
+
+			const auto & data = mDataArray[mIndex];
+			size_t n = std::min<size_t>(count, data.count - mElement);
+
+			switch(data.dataType)
+			{
+			case DataType::Float:
+				memcpy(p_values, data.floatList().data() + mElement, sizeof(float) * n);
+				break;
+			case DataType::Double:
+				convertDoubleToFloat(data.doubleList().data() + mElement, p_values, n);
+				break;
+			case DataType::Integer:
+				for(size_t i = 0; i < n; ++i)
+				{
+					p_values[i] = static_cast<float>(static_cast<int32_t>(data.numberList()[mElement + i]));
+				}
+				break;
+			default:
+				return false;
+			}
+
+			p_values += n;
+			count -= n;
+			mElement += n;
+		}
+
+		return true;
+	}
+
+	std::span<const XFileData> XFileDataCursor::remaining() const noexcept
+	{
+		size_t index = mIndex;
+		if(index < mDataArray.size() && mElement > 0)
+		{
+			++index;
+		}
+
+		return mDataArray.subspan(index);
+	}
+
+	bool XFileDataCursor::seekNumberList()
+	{
+		while(mIndex < mDataArray.size() && mElement == mDataArray[mIndex].count)
+		{
+			++mIndex;
+			mElement = 0;
+		}
+
+		if(mIndex == mDataArray.size())
+		{
+			return false;
+		}
+
+		auto data_type = mDataArray[mIndex].dataType;
+
+		return data_type == DataType::Integer || data_type == DataType::Float || data_type == DataType::Double;
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+#ifndef XFILE_XFILE_DATA_CURSOR_H_INCLUDED
+#define XFILE_XFILE_DATA_CURSOR_H_INCLUDED
+
+#include <cstdint>
+#include <span>
+#include "XFileData.h"
+
+namespace xfile
+{
+	// テンプレートのメンバーを先頭から順に読む
+	// 整数と浮動小数点数が混ざるメンバーは種類が切り替わるたびに別のリストになるので，
+	// リストの境目を気にせずに読めるようにする
+	class XFileDataCursor
+	{
+	public:
+		XFileDataCursor(std::span<const XFileData> data_array);
+
+		bool readInteger(uint32_t & value);
+
+		// 整数のリストが来た場合もfloatに変換して読む
+		bool readFloats(float * p_values, size_t count);
+
+		// 数値のリストを読み終えた後の，残りのデータ
+		std::span<const XFileData> remaining() const noexcept;
+
+	private:
+		bool seekNumberList();
+
+	private:
+		std::span<const XFileData> mDataArray;
+		size_t mIndex = 0;
+		size_t mElement = 0;
+	};
+}
+
+#endif // XFILE_XFILE_DATA_CURSOR_H_INCLUDED
@@ -0,0 +1,15 @@
+#pragma once
+#ifndef XFILE_XFILE_DOUBLE_VECTOR_H_INCLUDED
+#define XFILE_XFILE_DOUBLE_VECTOR_H_INCLUDED
+
+namespace xfile
+{
+	struct XFileDoubleVector
+	{
+		double x;
+		double y;
+		double z;
+	};
+}
+
+#endif // XFILE_XFILE_DOUBLE_VECTOR_H_INCLUDED
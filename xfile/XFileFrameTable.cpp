@@ -0,0 +1,142 @@
+#include "XFileFrameTable.h"
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define XFILE_USE_SSE2 1
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#include <arm_neon.h>
+#define XFILE_USE_NEON 1
+#endif
+
+namespace xfile
+{
+	uint32_t XFileFrameTable::add(std::string_view name, uint32_t parent, const XFileMatrix & local_matrix)
+	{
+		auto index = static_cast<uint32_t>(names.size());
+
+		names.emplace_back(name);
+		parents.emplace_back(parent);
+		localMatrices.emplace_back(local_matrix);
+		worldMatrices.emplace_back(local_matrix);
+
+		return index;
+	}
+
+	void XFileFrameTable::append(const XFileFrameTable & other)
+	{
+		auto offset = static_cast<uint32_t>(names.size());
+
+		names.insert(names.end(), other.names.begin(), other.names.end());
+		for(auto parent : other.parents)
+		{
+			parents.emplace_back(parent == NoParent ? NoParent : parent + offset);
+		}
+		localMatrices.insert(localMatrices.end(), other.localMatrices.begin(), other.localMatrices.end());
+		worldMatrices.insert(worldMatrices.end(), other.worldMatrices.begin(), other.worldMatrices.end());
+	}
+
+	void XFileFrameTable::clear()
+	{
+		names.clear();
+		parents.clear();
+		localMatrices.clear();
+		worldMatrices.clear();
+	}
+
+	uint32_t XFileFrameTable::find(std::string_view name) const
+	{
+		auto it = std::find(names.begin(), names.end(), name);
+		if(it == names.end())
+		{
+			return NoParent;
+		}
+
+		return static_cast<uint32_t>(it - names.begin());
+	}
+
+	void XFileFrameTable::updateWorldMatrices()
+	{
+		// 親は必ず前にあるので，親のワールド行列は計算済みになっている
+		for(size_t i = 0; i < parents.size(); ++i)
+		{
+			if(parents[i] == NoParent)
+			{
+				worldMatrices[i] = localMatrices[i];
+			}
+			else
+			{
+				multiplyMatrix(localMatrices[i], worldMatrices[parents[i]], worldMatrices[i]);
+			}
+		}
+	}
+
+	XFileMatrix identityMatrix() noexcept
+	{
+		return
+		{
+			{
+				{ 1.0f, 0.0f, 0.0f, 0.0f },
+				{ 0.0f, 1.0f, 0.0f, 0.0f },
+				{ 0.0f, 0.0f, 1.0f, 0.0f },
+				{ 0.0f, 0.0f, 0.0f, 1.0f },
+			}
+		};
+	}
+
+	void multiplyMatrix(const XFileMatrix & a, const XFileMatrix & b, XFileMatrix & result) noexcept
+	{
+#if XFILE_USE_SSE2
+		__m128 b0 = _mm_loadu_ps(b.m[0]);
+		__m128 b1 = _mm_loadu_ps(b.m[1]);
+		__m128 b2 = _mm_loadu_ps(b.m[2]);
+		__m128 b3 = _mm_loadu_ps(b.m[3]);
+
+		// 結果の各行はbの行をaの行の要素で重み付けした和になる
+		__m128 rows[4];
+		for(size_t i = 0; i < 4; ++i)
+		{
+			__m128 row = _mm_mul_ps(_mm_set1_ps(a.m[i][0]), b0);
+			row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a.m[i][1]), b1));
+			row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a.m[i][2]), b2));
+			row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a.m[i][3]), b3));
+			rows[i] = row;
+		}
+
+		for(size_t i = 0; i < 4; ++i)
+		{
+			_mm_storeu_ps(result.m[i], rows[i]);
+		}
+#elif XFILE_USE_NEON
+		float32x4_t b0 = vld1q_f32(b.m[0]);
+		float32x4_t b1 = vld1q_f32(b.m[1]);
+		float32x4_t b2 = vld1q_f32(b.m[2]);
+		float32x4_t b3 = vld1q_f32(b.m[3]);
+
+		float32x4_t rows[4];
+		for(size_t i = 0; i < 4; ++i)
+		{
+			float32x4_t row = vmulq_n_f32(b0, a.m[i][0]);
+			row = vmlaq_n_f32(row, b1, a.m[i][1]);
+			row = vmlaq_n_f32(row, b2, a.m[i][2]);
+			row = vmlaq_n_f32(row, b3, a.m[i][3]);
+			rows[i] = row;
+		}
+
+		for(size_t i = 0; i < 4; ++i)
+		{
+			vst1q_f32(result.m[i], rows[i]);
+		}
+#else
+		XFileMatrix product;
+		for(size_t i = 0; i < 4; ++i)
+		{
+			for(size_t j = 0; j < 4; ++j)
+			{
+				product.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j] + a.m[i][3] * b.m[3][j];
+			}
+		}
+		result = product;
+#endif
+	}
+}
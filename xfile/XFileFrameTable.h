@@ -0,0 +1,41 @@
+#pragma once
+#ifndef XFILE_XFILE_FRAME_TABLE_H_INCLUDED
+#define XFILE_XFILE_FRAME_TABLE_H_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "XFileMatrix.h"
+
+namespace xfile
+{
+	// Frameの階層を親が必ず子より前に来る順に並べた表
+	// 要素ごとの配列に分けて持つので，ワールド行列の計算は先頭から1回なめるだけで済む
+	struct XFileFrameTable
+	{
+		static constexpr uint32_t NoParent = UINT32_MAX;
+
+		uint32_t add(std::string_view name, uint32_t parent, const XFileMatrix & local_matrix);
+		void append(const XFileFrameTable & other);
+		void clear();
+
+		uint32_t find(std::string_view name) const;
+		size_t size() const noexcept { return names.size(); }
+
+		// localMatricesを書き換えたらフレームごとに呼ぶ
+		void updateWorldMatrices();
+
+		std::vector<std::string> names;
+		std::vector<uint32_t> parents;
+		std::vector<XFileMatrix> localMatrices;
+		std::vector<XFileMatrix> worldMatrices;
+	};
+
+	XFileMatrix identityMatrix() noexcept;
+
+	// a * bを計算する．resultはaやbと同じでもよい
+	void multiplyMatrix(const XFileMatrix & a, const XFileMatrix & b, XFileMatrix & result) noexcept;
+}
+
+#endif // XFILE_XFILE_FRAME_TABLE_H_INCLUDED
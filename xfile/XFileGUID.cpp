@@ -0,0 +1,73 @@
+#include "XFileGUID.h"
+#include <charconv>
+
+namespace
+{
+	template <class T>
+	bool parseHex(std::string_view & text, size_t digit_count, T & value)
+	{
+		if(text.size() < digit_count)
+		{
+			return false;
+		}
+
+		auto p_last = text.data() + digit_count;
+		auto result = std::from_chars(text.data(), p_last, value, 16);
+		if(result.ec != std::errc() || result.ptr != p_last)
+		{
+			return false;
+		}
+
+		text.remove_prefix(digit_count);
+
+		return true;
+	}
+
+	bool skipHyphen(std::string_view & text)
+	{
+		if(text.empty() || text.front() != '-')
+		{
+			return false;
+		}
+
+		text.remove_prefix(1);
+
+		return true;
+	}
+}
+
+namespace xfile
+{
+	bool XFileGUID::setup(std::string_view text)
+	{
+		if(!parseHex(text, 8, data1) || !skipHyphen(text))
+		{
+			return false;
+		}
+
+		if(!parseHex(text, 4, data2) || !skipHyphen(text))
+		{
+			return false;
+		}
+
+		if(!parseHex(text, 4, data3) || !skipHyphen(text))
+		{
+			return false;
+		}
+
+		for(size_t i = 0; i < 8; ++i)
+		{
+			if(i == 2 && !skipHyphen(text))
+			{
+				return false;
+			}
+
+			if(!parseHex(text, 2, data4[i]))
+			{
+				return false;
+			}
+		}
+
+		return text.empty();
+	}
+}
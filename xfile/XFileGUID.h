@@ -0,0 +1,24 @@
+#pragma once
+#ifndef XFILE_XFILE_GUID_H_INCLUDED
+#define XFILE_XFILE_GUID_H_INCLUDED
+
+#include <cstdint>
+#include <string_view>
+
+namespace xfile
+{
+	struct XFileGUID
+	{
+		// テキスト形式の"3D82AB44-62DA-11cf-AB39-0020AF71E433"を読み込む
+		bool setup(std::string_view text);
+
+		bool operator==(const XFileGUID &) const = default;
+
+		uint32_t data1;
+		uint16_t data2;
+		uint16_t data3;
+		uint8_t data4[8];
+	};
+}
+
+#endif // XFILE_XFILE_GUID_H_INCLUDED
@@ -0,0 +1,99 @@
+#include "XFileHash.h"
+#include <bit>
+#include <cstring>
+
+namespace
+{
+	constexpr uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+	constexpr uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+	constexpr uint64_t Prime3 = 0x165667B19E3779F9ull;
+	constexpr uint64_t Prime4 = 0x85EBCA77C2B2AE63ull;
+	constexpr uint64_t Prime5 = 0x27D4EB2F165667C5ull;
+
+	uint64_t load64(const std::byte * p) noexcept
+	{
+		uint64_t value;
+		memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	uint64_t round(uint64_t accumulator, uint64_t input) noexcept
+	{
+		accumulator += input * Prime2;
+		accumulator = std::rotl(accumulator, 31);
+		return accumulator * Prime1;
+	}
+
+	uint64_t mergeRound(uint64_t accumulator, uint64_t value) noexcept
+	{
+		accumulator ^= round(0, value);
+		return accumulator * Prime1 + Prime4;
+	}
+
+	uint64_t avalanche(uint64_t h) noexcept
+	{
+		h ^= h >> 33;
+		h *= Prime2;
+		h ^= h >> 29;
+		h *= Prime3;
+		h ^= h >> 32;
+		return h;
+	}
+}
+
+namespace xfile
+{
+	uint64_t hashBytes(std::span<const std::byte> bytes, uint64_t seed) noexcept
+	{
+		const std::byte * p = bytes.data();
+		const std::byte * p_end = p + bytes.size();
+		uint64_t h;
+
+		if(bytes.size() >= 32)
+		{
+			// 依存関係の無い4つの累積値に分けて，乗算の待ち時間を隠す
+			uint64_t v1 = seed + Prime1 + Prime2;
+			uint64_t v2 = seed + Prime2;
+			uint64_t v3 = seed;
+			uint64_t v4 = seed - Prime1;
+			for(; p + 32 <= p_end; p += 32)
+			{
+				v1 = round(v1, load64(p));
+				v2 = round(v2, load64(p + 8));
+				v3 = round(v3, load64(p + 16));
+				v4 = round(v4, load64(p + 24));
+			}
+
+			h = std::rotl(v1, 1) + std::rotl(v2, 7) + std::rotl(v3, 12) + std::rotl(v4, 18);
+			h = mergeRound(h, v1);
+			h = mergeRound(h, v2);
+			h = mergeRound(h, v3);
+			h = mergeRound(h, v4);
+		}
+		else
+		{
+			h = seed + Prime5;
+		}
+
+		h += static_cast<uint64_t>(bytes.size());
+
+		for(; p + 8 <= p_end; p += 8)
+		{
+			h ^= round(0, load64(p));
+			h = std::rotl(h, 27) * Prime1 + Prime4;
+		}
+
+		for(; p < p_end; ++p)
+		{
+			h ^= static_cast<uint64_t>(*p) * Prime5;
+			h = std::rotl(h, 11) * Prime1;
+		}
+
+		return avalanche(h);
+	}
+
+	uint64_t combineHash(uint64_t seed, uint64_t value) noexcept
+	{
+		return avalanche(round(seed, value) + Prime3);
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+#ifndef XFILE_XFILE_HASH_H_INCLUDED
+#define XFILE_XFILE_HASH_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace xfile
+{
+	// ファイルの中身が変わったかを調べるための64ビットのハッシュ
+	// 暗号学的な強さは無いが，4つのレーンを並行して回すので大きなファイルでも速い
+	uint64_t hashBytes(std::span<const std::byte> bytes, uint64_t seed = 0) noexcept;
+
+	// 順番に意味があるハッシュの組み合わせ
+	uint64_t combineHash(uint64_t seed, uint64_t value) noexcept;
+}
+
+#endif // XFILE_XFILE_HASH_H_INCLUDED
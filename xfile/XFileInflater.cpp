@@ -0,0 +1,637 @@
+#include "XFileInflater.h"
+#include <cstring>
+#include <utility>
+
+namespace
+{
+	// MSZIPの各ブロックは直前32KBの展開結果を辞書として参照する
+	constexpr size_t HistorySize = 32768;
+
+	constexpr uint16_t LengthBases[] =
+	{
+		3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+		35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+	};
+
+	constexpr uint8_t LengthExtraBits[] =
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+		3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+	};
+
+	constexpr uint16_t DistanceBases[] =
+	{
+		1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+		257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+	};
+
+	constexpr uint8_t DistanceExtraBits[] =
+	{
+		0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+		7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+	};
+
+	constexpr uint8_t CodeLengthOrder[] =
+	{
+		16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+	};
+
+	class BitReader
+	{
+	public:
+		BitReader(std::span<const std::byte> input)
+			: mpCursor(input.data())
+			, mpEnd(input.data() + input.size())
+		{
+		}
+
+		void fill()
+		{
+			while(mCount <= 56 && mpCursor < mpEnd)
+			{
+				mBits |= static_cast<uint64_t>(*mpCursor++) << mCount;
+				mCount += 8;
+			}
+		}
+
+		uint32_t available() const
+		{
+			return mCount;
+		}
+
+		uint32_t peek(uint32_t count) const
+		{
+			return static_cast<uint32_t>(mBits & ((uint64_t(1) << count) - 1));
+		}
+
+		void consume(uint32_t count)
+		{
+			mBits >>= count;
+			mCount -= count;
+		}
+
+		bool read(uint32_t count, uint32_t & value)
+		{
+			fill();
+			if(mCount < count)
+			{
+				return false;
+			}
+
+			value = peek(count);
+			consume(count);
+
+			return true;
+		}
+
+		void alignToByte()
+		{
+			consume(mCount % 8);
+		}
+
+		bool readBytes(std::byte * p_output, size_t size)
+		{
+			while(size > 0 && mCount >= 8)
+			{
+				*p_output++ = static_cast<std::byte>(peek(8));
+				consume(8);
+				--size;
+			}
+
+			if(static_cast<size_t>(mpEnd - mpCursor) < size)
+			{
+				return false;
+			}
+
+			memcpy(p_output, mpCursor, size);
+			mpCursor += size;
+
+			return true;
+		}
+
+	private:
+		const std::byte * mpCursor;
+		const std::byte * mpEnd;
+		uint64_t mBits = 0;
+		uint32_t mCount = 0;
+	};
+
+	struct Huffman
+	{
+		static constexpr uint32_t MaxBits = 15;
+		static constexpr uint32_t FastBits = 10;
+
+		bool build(const uint8_t * lengths, uint32_t count)
+		{
+			memset(counts, 0, sizeof(counts));
+			memset(fast, 0, sizeof(fast));
+
+			for(uint32_t symbol = 0; symbol < count; ++symbol)
+			{
+				++counts[lengths[symbol]];
+			}
+			counts[0] = 0;
+
+			int32_t left = 1;
+			for(uint32_t length = 1; length <= MaxBits; ++length)
+			{
+				left <<= 1;
+				left -= counts[length];
+				if(left < 0)
+				{
+					return false;
+				}
+			}
+
+			uint16_t offsets[MaxBits + 1];
+			uint16_t codes[MaxBits + 1];
+			offsets[1] = 0;
+			codes[1] = 0;
+			for(uint32_t length = 1; length < MaxBits; ++length)
+			{
+				offsets[length + 1] = offsets[length] + counts[length];
+				codes[length + 1] = static_cast<uint16_t>((codes[length] + counts[length]) << 1);
+			}
+
+			for(uint32_t symbol = 0; symbol < count; ++symbol)
+			{
+				uint32_t length = lengths[symbol];
+				if(length == 0)
+				{
+					continue;
+				}
+
+				symbols[offsets[length]++] = static_cast<uint16_t>(symbol);
+
+				uint32_t code = codes[length]++;
+				if(length > FastBits)
+				{
+					continue;
+				}
+
+				// deflateの符号はビット列の先頭から詰められているので反転して引く
+				uint32_t reversed = 0;
+				for(uint32_t i = 0; i < length; ++i)
+				{
+					reversed |= ((code >> i) & 1) << (length - 1 - i);
+				}
+
+				for(uint32_t i = reversed; i < (1u << FastBits); i += 1u << length)
+				{
+					fast[i] = static_cast<uint16_t>((symbol << 4) | length);
+				}
+			}
+
+			return true;
+		}
+
+		bool decode(BitReader & bits, uint32_t & symbol) const
+		{
+			bits.fill();
+
+			uint32_t entry = fast[bits.peek(FastBits)];
+			uint32_t length = entry & 15;
+			if(entry != 0 && length <= bits.available())
+			{
+				bits.consume(length);
+				symbol = entry >> 4;
+				return true;
+			}
+
+			int32_t code = 0;
+			int32_t first = 0;
+			int32_t index = 0;
+			for(length = 1; length <= MaxBits; ++length)
+			{
+				uint32_t bit;
+				if(!bits.read(1, bit))
+				{
+					return false;
+				}
+
+				code |= static_cast<int32_t>(bit);
+				int32_t count = counts[length];
+				if(code - count < first)
+				{
+					symbol = symbols[index + (code - first)];
+					return true;
+				}
+
+				index += count;
+				first += count;
+				first <<= 1;
+				code <<= 1;
+			}
+
+			return false;
+		}
+
+		uint16_t counts[MaxBits + 1];
+		uint16_t symbols[288];
+		uint16_t fast[1 << FastBits];
+	};
+
+	bool inflateCodes(BitReader & bits, const Huffman & literals, const Huffman & distances, std::vector<std::byte> & output)
+	{
+		while(true)
+		{
+			uint32_t symbol;
+			if(!literals.decode(bits, symbol))
+			{
+				return false;
+			}
+
+			if(symbol < 256)
+			{
+				output.push_back(static_cast<std::byte>(symbol));
+				continue;
+			}
+
+			if(symbol == 256)
+			{
+				return true;
+			}
+
+			symbol -= 257;
+			if(symbol >= std::size(LengthBases))
+			{
+				return false;
+			}
+
+			uint32_t extra;
+			if(!bits.read(LengthExtraBits[symbol], extra))
+			{
+				return false;
+			}
+			size_t length = LengthBases[symbol] + extra;
+
+			if(!distances.decode(bits, symbol) || symbol >= std::size(DistanceBases))
+			{
+				return false;
+			}
+
+			if(!bits.read(DistanceExtraBits[symbol], extra))
+			{
+				return false;
+			}
+			size_t distance = DistanceBases[symbol] + extra;
+
+			size_t position = output.size();
+			if(distance > position)
+			{
+				return false;
+			}
+
+			// 参照元と書き込み先が重なることがあるので1バイトずつコピーする
+			output.resize(position + length);
+			std::byte * p = output.data() + position;
+			for(size_t i = 0; i < length; ++i)
+			{
+				p[i] = p[i - distance];
+			}
+		}
+	}
+
+	bool inflateFixed(BitReader & bits, std::vector<std::byte> & output)
+	{
+		static const auto tables = []
+		{
+			std::pair<Huffman, Huffman> result;
+
+			uint8_t lengths[288];
+			memset(lengths, 8, 144);
+			memset(lengths + 144, 9, 112);
+			memset(lengths + 256, 7, 24);
+			memset(lengths + 280, 8, 8);
+			result.first.build(lengths, 288);
+
+			memset(lengths, 5, 30);
+			result.second.build(lengths, 30);
+
+			return result;
+		}();
+
+		return inflateCodes(bits, tables.first, tables.second, output);
+	}
+
+	bool inflateDynamic(BitReader & bits, std::vector<std::byte> & output)
+	{
+		uint32_t literal_count;
+		uint32_t distance_count;
+		uint32_t code_length_count;
+		if(!bits.read(5, literal_count) || !bits.read(5, distance_count) || !bits.read(4, code_length_count))
+		{
+			return false;
+		}
+
+		literal_count += 257;
+		distance_count += 1;
+		code_length_count += 4;
+		if(literal_count > 286 || distance_count > 30)
+		{
+			return false;
+		}
+
+		uint8_t lengths[286 + 30] = {};
+		for(uint32_t i = 0; i < code_length_count; ++i)
+		{
+			uint32_t length;
+			if(!bits.read(3, length))
+			{
+				return false;
+			}
+			lengths[CodeLengthOrder[i]] = static_cast<uint8_t>(length);
+		}
+
+		Huffman code_lengths;
+		if(!code_lengths.build(lengths, 19))
+		{
+			return false;
+		}
+
+		memset(lengths, 0, sizeof(lengths));
+		for(uint32_t i = 0; i < literal_count + distance_count;)
+		{
+			uint32_t symbol;
+			if(!code_lengths.decode(bits, symbol))
+			{
+				return false;
+			}
+
+			if(symbol < 16)
+			{
+				lengths[i++] = static_cast<uint8_t>(symbol);
+				continue;
+			}
+
+			uint8_t length = 0;
+			uint32_t repeat;
+			if(symbol == 16)
+			{
+				if(i == 0 || !bits.read(2, repeat))
+				{
+					return false;
+				}
+				length = lengths[i - 1];
+				repeat += 3;
+			}
+			else if(symbol == 17)
+			{
+				if(!bits.read(3, repeat))
+				{
+					return false;
+				}
+				repeat += 3;
+			}
+			else
+			{
+				if(!bits.read(7, repeat))
+				{
+					return false;
+				}
+				repeat += 11;
+			}
+
+			if(i + repeat > literal_count + distance_count)
+			{
+				return false;
+			}
+
+			while(repeat-- > 0)
+			{
+				lengths[i++] = length;
+			}
+		}
+
+		if(lengths[256] == 0)
+		{
+			return false;
+		}
+
+		Huffman literals;
+		Huffman distances;
+		if(!literals.build(lengths, literal_count) || !distances.build(lengths + literal_count, distance_count))
+		{
+			return false;
+		}
+
+		return inflateCodes(bits, literals, distances, output);
+	}
+
+	// outputの先頭には前のブロックまでの展開結果が辞書として入っている
+	bool inflate(std::span<const std::byte> input, std::vector<std::byte> & output)
+	{
+		BitReader bits(input);
+
+		uint32_t is_final = 0;
+		while(is_final == 0)
+		{
+			uint32_t type;
+			if(!bits.read(1, is_final) || !bits.read(2, type))
+			{
+				return false;
+			}
+
+			bool succeeded = false;
+			switch(type)
+			{
+			case 0:
+			{
+				bits.alignToByte();
+
+				uint32_t length;
+				uint32_t inverted_length;
+				if(!bits.read(16, length) || !bits.read(16, inverted_length) || length != (~inverted_length & 0xffff))
+				{
+					return false;
+				}
+
+				size_t position = output.size();
+				output.resize(position + length);
+				succeeded = bits.readBytes(output.data() + position, length);
+				break;
+			}
+			case 1:
+				succeeded = inflateFixed(bits, output);
+				break;
+			case 2:
+				succeeded = inflateDynamic(bits, output);
+				break;
+			default:
+				break;
+			}
+
+			if(!succeeded)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	uint16_t readUInt16(const std::byte * p)
+	{
+		uint16_t value;
+		memcpy(&value, p, sizeof(value));
+		return value;
+	}
+}
+
+namespace xfile
+{
+	XFileInflater::XFileInflater(std::span<const std::byte> compressed)
+		: mInput(compressed)
+	{
+		mWindow.reserve(HistorySize * 2);
+		mThread = std::thread(&XFileInflater::run, this);
+	}
+
+	XFileInflater::~XFileInflater()
+	{
+		{
+			std::lock_guard lock(mMutex);
+			mStopping = true;
+		}
+		mCondition.notify_all();
+
+		if(mThread.joinable())
+		{
+			mThread.join();
+		}
+	}
+
+	bool XFileInflater::next(std::vector<std::byte> & block)
+	{
+		std::unique_lock lock(mMutex);
+		mCondition.wait(lock, [this] { return !mBlocks.empty() || mFinished; });
+
+		if(mBlocks.empty())
+		{
+			return false;
+		}
+
+		// 呼び出し側が使い終わったバッファは次のブロックの展開先に回す
+		if(block.capacity() != 0)
+		{
+			block.clear();
+			mFreeBlocks.emplace_back(std::move(block));
+		}
+
+		block = std::move(mBlocks.front());
+		mBlocks.pop_front();
+		mConsumedBytes += mBlockInputSizes.front();
+		mBlockInputSizes.pop_front();
+		lock.unlock();
+
+		mCondition.notify_all();
+
+		return true;
+	}
+
+	bool XFileInflater::failed() const
+	{
+		std::lock_guard lock(mMutex);
+		return mFailed;
+	}
+
+	size_t XFileInflater::consumedBytes() const
+	{
+		std::lock_guard lock(mMutex);
+		return mConsumedBytes;
+	}
+
+	void XFileInflater::run()
+	{
+		while(true)
+		{
+			std::vector<std::byte> block;
+			{
+				std::unique_lock lock(mMutex);
+				mCondition.wait(lock, [this] { return mStopping || mBlocks.size() < QueueDepth; });
+				if(mStopping)
+				{
+					return;
+				}
+
+				if(!mFreeBlocks.empty())
+				{
+					block = std::move(mFreeBlocks.back());
+					mFreeBlocks.pop_back();
+				}
+			}
+
+			// 末尾のブロックヘッダに満たない余りは無視する
+			if(mInput.size() < 6)
+			{
+				{
+					std::lock_guard lock(mMutex);
+					mFinished = true;
+				}
+				mCondition.notify_all();
+				return;
+			}
+
+			size_t input_size = mInput.size();
+			bool succeeded = inflateBlock(block);
+			{
+				std::lock_guard lock(mMutex);
+				if(succeeded)
+				{
+					mBlocks.emplace_back(std::move(block));
+					mBlockInputSizes.emplace_back(input_size - mInput.size());
+				}
+				else
+				{
+					mFailed = true;
+					mFinished = true;
+				}
+			}
+			mCondition.notify_all();
+
+			if(!succeeded)
+			{
+				return;
+			}
+		}
+	}
+
+	bool XFileInflater::inflateBlock(std::vector<std::byte> & block)
+	{
+		// ブロックは展開後のサイズ(2バイト)，'CK'を含む圧縮後のサイズ(2バイト)，
+		// 'CK'，deflateで圧縮されたデータの順に並んでいる
+		uint16_t uncompressed_size = readUInt16(mInput.data());
+		uint16_t compressed_size = readUInt16(mInput.data() + 2);
+		if(compressed_size < 2 || mInput.size() - 4 < compressed_size)
+		{
+			return false;
+		}
+
+		if(mInput[4] != std::byte('C') || mInput[5] != std::byte('K'))
+		{
+			return false;
+		}
+
+		size_t history_size = mWindow.size();
+		if(!inflate(mInput.subspan(6, compressed_size - 2u), mWindow))
+		{
+			return false;
+		}
+
+		if(mWindow.size() - history_size != uncompressed_size)
+		{
+			return false;
+		}
+
+		block.assign(mWindow.begin() + static_cast<ptrdiff_t>(history_size), mWindow.end());
+
+		if(mWindow.size() > HistorySize)
+		{
+			mWindow.erase(mWindow.begin(), mWindow.end() - static_cast<ptrdiff_t>(HistorySize));
+		}
+
+		mInput = mInput.subspan(4u + compressed_size);
+
+		return true;
+	}
+}
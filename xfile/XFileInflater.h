@@ -0,0 +1,59 @@
+#pragma once
+#ifndef XFILE_XFILE_INFLATER_H_INCLUDED
+#define XFILE_XFILE_INFLATER_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace xfile
+{
+	// MSZIP形式で圧縮されたブロックを別スレッドで先行して展開する
+	// 展開済みのブロックは最大QueueDepth個までしか保持しないので，
+	// ファイルサイズによらず使用メモリは一定になる
+	class XFileInflater
+	{
+	public:
+		static constexpr size_t QueueDepth = 2;
+
+		XFileInflater(std::span<const std::byte> compressed);
+
+		XFileInflater(const XFileInflater &) = delete;
+		XFileInflater & operator=(const XFileInflater &) = delete;
+
+		~XFileInflater();
+
+		bool next(std::vector<std::byte> & block);
+		bool failed() const;
+
+		// nextで渡し終えたブロックの圧縮後のバイト数
+		size_t consumedBytes() const;
+
+	private:
+		void run();
+		bool inflateBlock(std::vector<std::byte> & block);
+
+	private:
+		std::span<const std::byte> mInput;
+		std::vector<std::byte> mWindow;
+
+		mutable std::mutex mMutex;
+		std::condition_variable mCondition;
+		std::deque<std::vector<std::byte>> mBlocks;
+		std::deque<size_t> mBlockInputSizes;
+		size_t mConsumedBytes = 0;
+		std::vector<std::vector<std::byte>> mFreeBlocks;
+		bool mFinished = false;
+		bool mFailed = false;
+		bool mStopping = false;
+
+		std::thread mThread;
+	};
+}
+
+#endif // XFILE_XFILE_INFLATER_H_INCLUDED
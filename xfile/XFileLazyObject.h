@@ -0,0 +1,43 @@
+#pragma once
+#ifndef XFILE_XFILE_LAZY_OBJECT_H_INCLUDED
+#define XFILE_XFILE_LAZY_OBJECT_H_INCLUDED
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include "XFileSource.h"
+
+namespace xfile
+{
+	// 読み飛ばした子オブジェクトの入力での範囲．XFileVisitor::lazyObjectで渡される
+	// bytesは'{'から対応する'}'までを指す
+	struct XFileLazyRange
+	{
+		std::string_view name;
+		std::string_view optionalName;
+		std::span<const std::byte> bytes;
+		const XFileSource * pSource;
+	};
+
+	// XFileLazyRangeをツリーより長く残すためのもの．pSourceで入力を保持する
+	struct XFileLazyObject
+	{
+		XFileLazyObject() = default;
+		XFileLazyObject(const XFileLazyRange & range)
+			: name(range.name)
+			, optionalName(range.optionalName)
+			, bytes(range.bytes)
+			, pSource(range.pSource->shared_from_this())
+		{
+		}
+
+		std::string name;
+		std::string optionalName;
+		std::span<const std::byte> bytes;
+		std::shared_ptr<const XFileSource> pSource;
+	};
+}
+
+#endif // XFILE_XFILE_LAZY_OBJECT_H_INCLUDED
@@ -0,0 +1,20 @@
+#pragma once
+#ifndef XFILE_XFILE_LOAD_PROGRESS_H_INCLUDED
+#define XFILE_XFILE_LOAD_PROGRESS_H_INCLUDED
+
+#include <atomic>
+#include <cstdint>
+
+namespace xfile
+{
+	// 読み込み中のスレッドが更新するので，ほかのスレッドからいつでも読める
+	// consumedBytesは圧縮形式でも展開前のファイル上のバイト数で数える
+	struct XFileLoadProgress
+	{
+		std::atomic<uint64_t> consumedBytes = 0;
+		std::atomic<uint64_t> totalBytes = 0;
+		std::atomic<uint32_t> decodedObjects = 0;
+	};
+}
+
+#endif // XFILE_XFILE_LOAD_PROGRESS_H_INCLUDED
@@ -0,0 +1,19 @@
+#pragma once
+#ifndef XFILE_XFILE_LOAD_RESULT_H_INCLUDED
+#define XFILE_XFILE_LOAD_RESULT_H_INCLUDED
+
+#include <string>
+#include "XFile.h"
+
+namespace xfile
+{
+	struct XFileLoadResult
+	{
+		std::string path;
+		bool succeeded = false;
+		bool cancelled = false;
+		XFile xfile;
+	};
+}
+
+#endif // XFILE_XFILE_LOAD_RESULT_H_INCLUDED
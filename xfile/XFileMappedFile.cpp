@@ -0,0 +1,185 @@
+#include "XFileMappedFile.h"
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace xfile
+{
+	XFileMappedFile::XFileMappedFile(const char * p_file_path)
+	{
+		open(p_file_path);
+	}
+
+	XFileMappedFile::XFileMappedFile(XFileMappedFile && other) noexcept
+	{
+		swap(other);
+	}
+
+	XFileMappedFile & XFileMappedFile::operator=(XFileMappedFile && other) noexcept
+	{
+		if(this != &other)
+		{
+			close();
+			swap(other);
+		}
+
+		return *this;
+	}
+
+	XFileMappedFile::~XFileMappedFile()
+	{
+		close();
+	}
+
+#if defined(_WIN32)
+	bool XFileMappedFile::open(const char * p_file_path)
+	{
+		if(isOpen())
+		{
+			return false;
+		}
+
+		HANDLE h_file = CreateFileA(
+			p_file_path,
+			GENERIC_READ,
+			FILE_SHARE_READ,
+			nullptr,
+			OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+			nullptr
+		);
+		if(h_file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		mhFile = h_file;
+
+		LARGE_INTEGER file_size;
+		if(!GetFileSizeEx(h_file, &file_size) || file_size.QuadPart == 0)
+		{
+			close();
+			return false;
+		}
+
+		HANDLE h_mapping = CreateFileMappingA(h_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if(h_mapping == nullptr)
+		{
+			close();
+			return false;
+		}
+		mhMapping = h_mapping;
+
+		void * p_view = MapViewOfFile(h_mapping, FILE_MAP_READ, 0, 0, 0);
+		if(p_view == nullptr)
+		{
+			close();
+			return false;
+		}
+
+		mpData = static_cast<const std::byte *>(p_view);
+		mSize = static_cast<size_t>(file_size.QuadPart);
+
+		return true;
+	}
+
+	bool XFileMappedFile::close()
+	{
+		if(mpData != nullptr)
+		{
+			UnmapViewOfFile(mpData);
+			mpData = nullptr;
+			mSize = 0;
+		}
+
+		if(mhMapping != nullptr)
+		{
+			CloseHandle(mhMapping);
+			mhMapping = nullptr;
+		}
+
+		if(mhFile != nullptr)
+		{
+			CloseHandle(mhFile);
+			mhFile = nullptr;
+		}
+
+		return true;
+	}
+#else
+	bool XFileMappedFile::open(const char * p_file_path)
+	{
+		if(isOpen())
+		{
+			return false;
+		}
+
+		mFileDescriptor = ::open(p_file_path, O_RDONLY);
+		if(mFileDescriptor < 0)
+		{
+			return false;
+		}
+
+		struct stat file_stat;
+		if(fstat(mFileDescriptor, &file_stat) != 0 || file_stat.st_size == 0)
+		{
+			close();
+			return false;
+		}
+
+		void * p_view = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, mFileDescriptor, 0);
+		if(p_view == MAP_FAILED)
+		{
+			close();
+			return false;
+		}
+
+		// トークンは先頭から順番に読むので先読みを促しておく
+		madvise(p_view, static_cast<size_t>(file_stat.st_size), MADV_SEQUENTIAL);
+
+		mpData = static_cast<const std::byte *>(p_view);
+		mSize = static_cast<size_t>(file_stat.st_size);
+
+		return true;
+	}
+
+	bool XFileMappedFile::close()
+	{
+		if(mpData != nullptr)
+		{
+			munmap(const_cast<std::byte *>(mpData), mSize);
+			mpData = nullptr;
+			mSize = 0;
+		}
+
+		if(mFileDescriptor >= 0)
+		{
+			::close(mFileDescriptor);
+			mFileDescriptor = -1;
+		}
+
+		return true;
+	}
+#endif
+
+	void XFileMappedFile::swap(XFileMappedFile & other) noexcept
+	{
+#if defined(_WIN32)
+		std::swap(mhFile, other.mhFile);
+		std::swap(mhMapping, other.mhMapping);
+#else
+		std::swap(mFileDescriptor, other.mFileDescriptor);
+#endif
+		std::swap(mpData, other.mpData);
+		std::swap(mSize, other.mSize);
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+#ifndef XFILE_XFILE_MAPPED_FILE_H_INCLUDED
+#define XFILE_XFILE_MAPPED_FILE_H_INCLUDED
+
+#include <cstddef>
+#include <span>
+
+namespace xfile
+{
+	class XFileMappedFile
+	{
+	public:
+		XFileMappedFile() = default;
+		XFileMappedFile(const char * p_file_path);
+
+		XFileMappedFile(const XFileMappedFile &) = delete;
+		XFileMappedFile & operator=(const XFileMappedFile &) = delete;
+
+		XFileMappedFile(XFileMappedFile && other) noexcept;
+		XFileMappedFile & operator=(XFileMappedFile && other) noexcept;
+
+		~XFileMappedFile();
+
+		bool open(const char * p_file_path);
+		bool close();
+
+		bool isOpen() const noexcept { return mpData != nullptr; }
+		std::span<const std::byte> bytes() const noexcept { return { mpData, mSize }; }
+
+	private:
+		void swap(XFileMappedFile & other) noexcept;
+
+	private:
+#if defined(_WIN32)
+		void * mhFile = nullptr;
+		void * mhMapping = nullptr;
+#else
+		int mFileDescriptor = -1;
+#endif
+		const std::byte * mpData = nullptr;
+		size_t mSize = 0;
+	};
+}
+
+#endif // XFILE_XFILE_MAPPED_FILE_H_INCLUDED
@@ -9,13 +9,8 @@ namespace xfile
 			return false;
 		}
 
-		if(object.dataArray[0].dataType != DataType::Float)
-		{
-			return false;
-		}
-
-		auto & float_list = object.dataArray[0].floatList;
-		if(float_list.size() != 11)
+		float float_list[11];
+		if(!object.dataArray[0].copyFloatList(float_list, 11))
 		{
 			return false;
 		}
@@ -42,7 +37,7 @@ namespace xfile
 			return false;
 		}
 
-		if(!textureFilename.setup(*object.dataArray[1].object))
+		if(!textureFilename.setup(*object.dataArray[1].object()))
 		{
 			return false;
 		}
@@ -0,0 +1,14 @@
+#pragma once
+#ifndef XFILE_XFILE_MATRIX_H_INCLUDED
+#define XFILE_XFILE_MATRIX_H_INCLUDED
+
+namespace xfile
+{
+	// Matrix4x4と同じ行優先の並び(行ベクトルに右から掛ける)
+	struct XFileMatrix
+	{
+		float m[4][4];
+	};
+}
+
+#endif // XFILE_XFILE_MATRIX_H_INCLUDED
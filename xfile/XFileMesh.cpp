@@ -1,8 +1,11 @@
 #include "XFileMesh.h"
+#include <algorithm>
+#include "XFileObjectBuilder.h"
+#include "XFileReader.h"
 
 namespace xfile
 {
-	bool XFileMesh::setup(const XFileObject & object)
+	bool XFileMesh::setup(const XFileObject & object, bool keep_precise_vertices)
 	{
 		if(object.name.compare("Mesh") != 0)
 		{
@@ -16,81 +19,234 @@ namespace xfile
 			return false;
 		}
 
-		if(object.dataArray[0].numberList.size() != 1)
+		if(object.dataArray[0].numberList().size() != 1)
 		{
 			return false;
 		}
 
-		auto vertex_count = object.dataArray[0].numberList[0];
+		auto vertex_count = object.dataArray[0].numberList()[0];
 		vertices.resize(vertex_count);
 
-		if(object.dataArray[1].dataType != DataType::Float)
+		if(!object.dataArray[1].copyFloatList(reinterpret_cast<float *>(vertices.data()), vertex_count * 3))
 		{
 			return false;
 		}
 
-		if(object.dataArray[1].floatList.size() != vertex_count * 3)
+		if(keep_precise_vertices && object.dataArray[1].dataType == DataType::Double)
 		{
-			return false;
+			preciseVertices.resize(vertex_count);
+			memcpy(
+				preciseVertices.data(),
+				object.dataArray[1].doubleList().data(),
+				sizeof(XFileDoubleVector) * vertex_count
+			);
 		}
 
-		memcpy(
-			vertices.data(),
-			object.dataArray[1].floatList.data(),
-			sizeof(object.dataArray[1].floatList[0]) * object.dataArray[1].floatList.size()
-		); 
 		if(object.dataArray[2].dataType != DataType::Integer)
 		{
 			return false;
 		}
 
-		auto & f = object.dataArray[2].numberList;
-		[[maybe_unused]] auto face_count = f[0];
+		auto f = object.dataArray[2].numberList();
+		if(!triangulation.setup(f, vertices))
+		{
+			return false;
+		}
 
-		for(size_t i = 1; i < f.size();)
+		if(!triangulation.triangulate(f, faceIndices))
 		{
-			auto face_index_count = f[i];
-			if(face_index_count != 3)
+			return false;
+		}
+
+		for(size_t i = 3; i < object.dataArray.size(); ++i)
+		{
+			if(object.dataArray[i].dataType == DataType::Lazy)
+			{
+				lazyObjects.emplace_back(*object.dataArray[i].lazyRange());
+				continue;
+			}
+
+			if(object.dataArray[i].dataType != DataType::Object)
 			{
 				return false;
 			}
 
-			XFileMeshFace mesh_face
+			if(!setupChild(*object.dataArray[i].object()))
 			{
-				.faceVertexIndices = { f[i + 1], f[i + 2], f[i + 3] }
-			};
+				return false;
+			}
+		}
+
+		if(!skinWeights.empty() && !setupInfluences())
+		{
+			return false;
+		}
 
-			faces.emplace_back(std::move(mesh_face));
+		return true;
+	}
 
-			i += 4;
+	bool XFileMesh::setupChild(const XFileObject & object)
+	{
+		if(object.name.compare("MeshNormals") == 0)
+		{
+			return normals.setup(object, &triangulation);
 		}
+		else if(object.name.compare("MeshTextureCoords") == 0)
+		{
+			return textureCoords.setup(object);
+		}
+		else if(object.name.compare("MeshMaterialList") == 0)
+		{
+			if(!materialList.setup(object))
+			{
+				return false;
+			}
 
-		for(size_t i = 3; i < object.dataArray.size(); ++i)
+			triangulation.remapFaceIndexes(materialList.faceIndexes);
+		}
+		else if(object.name.compare("XSkinMeshHeader") == 0)
 		{
-			if(object.dataArray[i].dataType != DataType::Object)
+			return skinMeshHeader.setup(object);
+		}
+		else if(object.name.compare("SkinWeights") == 0)
+		{
+			XFileSkinWeights skin_weights;
+			if(!skin_weights.setup(object))
 			{
 				return false;
 			}
 
-			if(object.dataArray[i].object->name.compare("MeshNormals") == 0)
+			skinWeights.emplace_back(std::move(skin_weights));
+		}
+
+		return true;
+	}
+
+	const XFileMeshNormals * XFileMesh::findNormals()
+	{
+		if(!loadLazyObject("MeshNormals") || normals.normals.empty())
+		{
+			return nullptr;
+		}
+
+		return &normals;
+	}
+
+	const XFileMeshTextureCoords * XFileMesh::findTextureCoords()
+	{
+		if(!loadLazyObject("MeshTextureCoords") || textureCoords.textureCoords.empty())
+		{
+			return nullptr;
+		}
+
+		return &textureCoords;
+	}
+
+	const XFileMeshMaterialList * XFileMesh::findMaterialList()
+	{
+		if(!loadLazyObject("MeshMaterialList") || materialList.materials.empty())
+		{
+			return nullptr;
+		}
+
+		return &materialList;
+	}
+
+	bool XFileMesh::loadLazyObjects()
+	{
+		bool succeeded = true;
+		while(!lazyObjects.empty())
+		{
+			// 読み込むとlazyObjectsから取り除かれるので，名前はコピーしておく
+			std::string name = lazyObjects.front().name;
+			succeeded = loadLazyObject(name) && succeeded;
+		}
+
+		return succeeded;
+	}
+
+	bool XFileMesh::loadLazyObject(std::string_view object_name)
+	{
+		auto p_lazy_object = std::find_if(lazyObjects.begin(), lazyObjects.end(), [object_name](const XFileLazyObject & lazy_object)
+		{
+			return lazy_object.name == object_name;
+		});
+		if(p_lazy_object == lazyObjects.end())
+		{
+			return true;
+		}
+
+		// 失敗しても読み直さないように，先に取り除いておく
+		auto lazy_object = std::move(*p_lazy_object);
+		lazyObjects.erase(p_lazy_object);
+
+		// リストはリーダーのバッファを指すので，setupが終わるまでリーダーを残しておく
+		XFileReader reader;
+		XFileObjectBuilder builder(std::pmr::get_default_resource(), XFileListStorage::Reference);
+		if(!reader.readLazyObject(lazy_object, builder) || builder.objects.size() != 1)
+		{
+			return false;
+		}
+
+		return setupChild(builder.objects.front());
+	}
+
+	bool XFileMesh::setupInfluences()
+	{
+		if(skinWeights.size() > UINT16_MAX)
+		{
+			return false;
+		}
+
+		influences.assign(vertices.size(), XFileVertexInfluence{});
+
+		for(size_t bone = 0; bone < skinWeights.size(); ++bone)
+		{
+			const auto & skin_weights = skinWeights[bone];
+			for(size_t i = 0; i < skin_weights.vertexIndices.size(); ++i)
 			{
-				if(!normals.setup(*object.dataArray[i].object))
+				auto vertex_index = skin_weights.vertexIndices[i];
+				auto weight = skin_weights.weights[i];
+				if(vertex_index >= influences.size())
 				{
 					return false;
 				}
-			}
-			else if(object.dataArray[i].object->name.compare("MeshTextureCoords") == 0)
-			{
-				if(!textureCoords.setup(*object.dataArray[i].object))
+
+				// 重みの大きい順に並べておき，5本目以降は一番小さいものから捨てる
+				auto & influence = influences[vertex_index];
+				uint32_t slot = XFileVertexInfluence::MaxBones;
+				while(slot > 0 && influence.weights[slot - 1] < weight)
 				{
-					return false;
+					if(slot < XFileVertexInfluence::MaxBones)
+					{
+						influence.weights[slot] = influence.weights[slot - 1];
+						influence.boneIndices[slot] = influence.boneIndices[slot - 1];
+					}
+					--slot;
+				}
+
+				if(slot < XFileVertexInfluence::MaxBones)
+				{
+					influence.weights[slot] = weight;
+					influence.boneIndices[slot] = static_cast<uint16_t>(bone);
 				}
 			}
-			else if(object.dataArray[i].object->name.compare("MeshMaterialList") == 0)
+		}
+
+		// 捨てた分があっても合計が1になるようにする
+		for(auto & influence : influences)
+		{
+			float total = 0.0f;
+			for(auto weight : influence.weights)
+			{
+				total += weight;
+			}
+
+			if(total > 0.0f)
 			{
-				if(!materialList.setup(*object.dataArray[i].object))
+				for(auto & weight : influence.weights)
 				{
-					return false;
+					weight /= total;
 				}
 			}
 		}
@@ -6,11 +6,16 @@
 #include <string>
 #include <vector>
 #include "XFileObject.h"
+#include "XFileLazyObject.h"
 #include "XFileVector.h"
-#include "XFileMeshFace.h"
+#include "XFileDoubleVector.h"
+#include "XFileMeshTriangulation.h"
 #include "XFileMeshNormals.h"
 #include "XFileMeshTextureCoords.h"
 #include "XFileMeshMaterialList.h"
+#include "XFileSkinMeshHeader.h"
+#include "XFileSkinWeights.h"
+#include "XFileVertexInfluence.h"
 
 namespace xfile
 {
@@ -18,14 +23,51 @@ namespace xfile
 
 	struct XFileMesh
 	{
-		bool setup(const XFileObject & object);
+		// keep_precise_verticesがtrueで64ビットのファイルであれば，
+		// 変換前の頂点座標もpreciseVerticesに残す
+		bool setup(const XFileObject & object, bool keep_precise_vertices = false);
+
+		size_t faceCount() const noexcept { return faceIndices.size() / 3; }
 
 		std::string name;
+
+		// 属しているXFileFrameTableのフレームの番号．トップレベルのメッシュはUINT32_MAX
+		uint32_t frameIndex = UINT32_MAX;
 		std::vector<XFileVector> vertices;
-		std::vector<XFileMeshFace> faces;
+		std::vector<XFileDoubleVector> preciseVertices;
+		// 三角形ごとに頂点番号を3つずつ並べたもの．そのままインデックスバッファにできる
+		// 多角形の面は三角形に分けて入れ，元の面ごとの三角形の範囲はtriangulationに残す
+		std::vector<uint32_t> faceIndices;
+		XFileMeshTriangulation triangulation;
 		XFileMeshNormals normals;
 		XFileMeshTextureCoords textureCoords;
 		XFileMeshMaterialList materialList;
+
+		// スキンメッシュでなければskinWeightsとinfluencesは空になる
+		XFileSkinMeshHeader skinMeshHeader;
+		std::vector<XFileSkinWeights> skinWeights;
+
+		// skinWeightsを頂点ごとに並べ替えたもの．verticesと同じ数だけある
+		std::vector<XFileVertexInfluence> influences;
+
+		// XFileReader::setLazyMeshChildrenで読み飛ばした子オブジェクト
+		// 遅延読み込みでは，normals，textureCoords，materialListを直接使わずに下のfind系の関数を使う
+		std::vector<XFileLazyObject> lazyObjects;
+
+		// 最初に呼んだときに読み飛ばした子オブジェクトを読み込む．無い場合と読み込めなかった場合はnullptr
+		// 読み込むとlazyObjectsが変わるので，同じメッシュに対して複数のスレッドから呼ばないこと
+		const XFileMeshNormals * findNormals();
+		const XFileMeshTextureCoords * findTextureCoords();
+		const XFileMeshMaterialList * findMaterialList();
+
+		// 読み飛ばした子オブジェクトを全て読み込み，normals，textureCoords，materialListを直接使えるようにする
+		// 1つでも読み込めなければfalse
+		bool loadLazyObjects();
+
+	private:
+		bool setupChild(const XFileObject & object);
+		bool setupInfluences();
+		bool loadLazyObject(std::string_view object_name);
 	};
 }
 
@@ -15,13 +15,13 @@ namespace xfile
 		}
 
 		[[maybe_unused]]
-		auto material_count = object.dataArray[0].numberList[0];
+		auto material_count = object.dataArray[0].numberList()[0];
 
-		auto face_index_count = object.dataArray[0].numberList[1];
+		auto face_index_count = object.dataArray[0].numberList()[1];
 		faceIndexes.resize(face_index_count);
 		memcpy(
 			faceIndexes.data(),
-			&object.dataArray[0].numberList[2],
+			&object.dataArray[0].numberList()[2],
 			sizeof(uint32_t) * face_index_count
 		);
 
@@ -33,7 +33,7 @@ namespace xfile
 			}
 
 			XFileMaterial material;
-			if(!material.setup(*object.dataArray[i].object))
+			if(!material.setup(*object.dataArray[i].object()))
 			{
 				return false;
 			}
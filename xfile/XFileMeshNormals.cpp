@@ -2,7 +2,7 @@
 
 namespace xfile
 {
-	bool XFileMeshNormals::setup(const XFileObject & object)
+	bool XFileMeshNormals::setup(const XFileObject & object, const XFileMeshTriangulation * p_triangulation)
 	{
 		if(object.name.compare("MeshNormals") != 0)
 		{
@@ -14,53 +14,31 @@ namespace xfile
 			return false;
 		}
 
-		if(object.dataArray[0].numberList.size() != 1)
+		if(object.dataArray[0].numberList().size() != 1)
 		{
 			return false;
 		}
 
-		auto normal_count = object.dataArray[0].numberList[0];
+		auto normal_count = object.dataArray[0].numberList()[0];
 		normals.resize(normal_count);
 
-		if(object.dataArray[1].dataType != DataType::Float)
+		if(!object.dataArray[1].copyFloatList(reinterpret_cast<float *>(normals.data()), normal_count * 3))
 		{
 			return false;
 		}
 
-		if(object.dataArray[1].floatList.size() != normal_count * 3)
-		{
-			return false;
-		}
-
-		memcpy(normals.data(), object.dataArray[1].floatList.data(), sizeof(float) * normal_count);
-
 		if(object.dataArray[2].dataType != DataType::Integer)
 		{
 			return false;
 		}
 
-		auto & f = object.dataArray[2].numberList;
-		[[maybe_unused]] auto face_count = f[0];
-
-		for(size_t i = 1; i < f.size();)
+		const XFileMeshTriangulation triangles_only;
+		auto & triangulation = p_triangulation != nullptr ? *p_triangulation : triangles_only;
+		if(!triangulation.triangulate(object.dataArray[2].numberList(), faceNormalIndices))
 		{
-			auto face_index_count = f[i];
-			if(face_index_count != 3)
-			{
-				return false;
-			}
-
-			XFileMeshFace mesh_face
-			{
-				.faceVertexIndices = { f[i + 1], f[i + 2], f[i + 3] }
-			};
-
-			faceNormals.emplace_back(std::move(mesh_face));
-
-			i += 4;
+			return false;
 		}
 
-
 		return true;
 	}
 }
@@ -5,17 +5,19 @@
 #include <cstdint>
 #include <vector>
 #include "XFileVector.h"
-#include "XFileMeshFace.h"
+#include "XFileMeshTriangulation.h"
 #include "XFileObject.h"
 
 namespace xfile
 {
 	struct XFileMeshNormals
 	{
-		bool setup(const XFileObject & object);
+		// p_triangulationにはメッシュの面の分け方を渡す．nullptrであれば三角形の面しか読めない
+		bool setup(const XFileObject & object, const XFileMeshTriangulation * p_triangulation = nullptr);
 
 		std::vector<XFileVector> normals;
-		std::vector<XFileMeshFace> faceNormals;
+		// XFileMesh::faceIndicesと同じ並びで，三角形ごとに法線の番号を3つずつ並べたもの
+		std::vector<uint32_t> faceNormalIndices;
 	};
 }
 
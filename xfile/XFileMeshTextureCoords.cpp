@@ -14,14 +14,13 @@ namespace xfile
 			return false;
 		}
 
-		auto texture_coord_count = object.dataArray[0].numberList[0];
+		auto texture_coord_count = object.dataArray[0].numberList()[0];
 		textureCoords.resize(texture_coord_count);
 
-		memcpy(
-			textureCoords.data(),
-			object.dataArray[1].floatList.data(),
-			sizeof(XFileCoords2d) * texture_coord_count
-		);
+		if(!object.dataArray[1].copyFloatList(reinterpret_cast<float *>(textureCoords.data()), texture_coord_count * 2))
+		{
+			return false;
+		}
 
 		return true;
 	}
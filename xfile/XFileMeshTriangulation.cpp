@@ -0,0 +1,323 @@
+#include "XFileMeshTriangulation.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+	struct Point
+	{
+		float x;
+		float y;
+	};
+
+	// oから見てaからbへ左に回っていれば正になる
+	float cross(const Point & o, const Point & a, const Point & b) noexcept
+	{
+		return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+	}
+
+	bool isEar(const std::vector<Point> & points, const std::vector<uint32_t> & remaining, uint32_t prev, uint32_t current, uint32_t next)
+	{
+		auto & a = points[prev];
+		auto & b = points[current];
+		auto & c = points[next];
+		if(cross(a, b, c) <= 0.0f)
+		{
+			return false;
+		}
+
+		for(auto other : remaining)
+		{
+			if(other == prev || other == current || other == next)
+			{
+				continue;
+			}
+
+			auto & p = points[other];
+			if(cross(a, b, p) >= 0.0f && cross(b, c, p) >= 0.0f && cross(c, a, p) >= 0.0f)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void appendFan(const std::vector<uint32_t> & polygon_corners, std::vector<uint32_t> & corners)
+	{
+		for(size_t i = 1; i + 1 < polygon_corners.size(); ++i)
+		{
+			corners.insert(corners.end(), { polygon_corners[0], polygon_corners[i], polygon_corners[i + 1] });
+		}
+	}
+
+	void triangulatePolygon(
+		std::span<const xfile::XFileVector> positions,
+		std::span<const uint32_t> polygon,
+		std::vector<Point> & points,
+		std::vector<uint32_t> & remaining,
+		std::vector<uint32_t> & corners
+	)
+	{
+		const auto n = polygon.size();
+
+		remaining.resize(n);
+		std::iota(remaining.begin(), remaining.end(), 0u);
+
+		if(n == 3)
+		{
+			appendFan(remaining, corners);
+			return;
+		}
+
+		// Newellの方法で面の向きを求める
+		float nx = 0.0f;
+		float ny = 0.0f;
+		float nz = 0.0f;
+		for(size_t i = 0; i < n; ++i)
+		{
+			auto & a = positions[polygon[i]];
+			auto & b = positions[polygon[(i + 1) % n]];
+			nx += (a.y - b.y) * (a.z + b.z);
+			ny += (a.z - b.z) * (a.x + b.x);
+			nz += (a.x - b.x) * (a.y + b.y);
+		}
+
+		// 法線の成分が最も大きい軸を落として平面に写す．裏を向いていれば反転して左回りにそろえる
+		const float ax = std::abs(nx);
+		const float ay = std::abs(ny);
+		const float az = std::abs(nz);
+		if(ax == 0.0f && ay == 0.0f && az == 0.0f)
+		{
+			appendFan(remaining, corners);
+			return;
+		}
+
+		points.resize(n);
+		for(size_t i = 0; i < n; ++i)
+		{
+			auto & p = positions[polygon[i]];
+			if(az >= ax && az >= ay)
+			{
+				points[i] = { p.x, nz < 0.0f ? -p.y : p.y };
+			}
+			else if(ax >= ay)
+			{
+				points[i] = { p.y, nx < 0.0f ? -p.z : p.z };
+			}
+			else
+			{
+				points[i] = { p.z, ny < 0.0f ? -p.x : p.x };
+			}
+		}
+
+		// 凸多角形であれば扇形に分ける
+		bool convex = true;
+		for(size_t i = 0; i < n && convex; ++i)
+		{
+			convex = cross(points[(i + n - 1) % n], points[i], points[(i + 1) % n]) >= 0.0f;
+		}
+
+		if(convex)
+		{
+			appendFan(remaining, corners);
+			return;
+		}
+
+		// 耳を1つずつ切り取る．自己交差などで耳が見つからなくなったら，残りは扇形に分ける
+		size_t i = 0;
+		size_t misses = 0;
+		while(remaining.size() > 3 && misses < remaining.size())
+		{
+			const auto count = remaining.size();
+			const auto j = i % count;
+			const auto prev = remaining[(j + count - 1) % count];
+			const auto current = remaining[j];
+			const auto next = remaining[(j + 1) % count];
+
+			if(isEar(points, remaining, prev, current, next))
+			{
+				corners.insert(corners.end(), { prev, current, next });
+				remaining.erase(remaining.begin() + static_cast<std::ptrdiff_t>(j));
+				i = j;
+				misses = 0;
+			}
+			else
+			{
+				i = j + 1;
+				++misses;
+			}
+		}
+
+		appendFan(remaining, corners);
+	}
+}
+
+namespace xfile
+{
+	bool XFileMeshTriangulation::setup(std::span<const uint32_t> face_list, std::span<const XFileVector> positions)
+	{
+		faceTriangleOffsets.clear();
+		corners.clear();
+
+		if(face_list.empty())
+		{
+			return false;
+		}
+
+		const auto face_count = face_list[0];
+
+		bool triangles_only = true;
+		size_t i = 1;
+		for(uint32_t face = 0; face < face_count; ++face)
+		{
+			if(i >= face_list.size())
+			{
+				return false;
+			}
+
+			const auto face_index_count = face_list[i];
+			if(face_index_count < 3 || face_list.size() - i - 1 < face_index_count)
+			{
+				return false;
+			}
+
+			triangles_only = triangles_only && face_index_count == 3;
+			i += face_index_count + 1;
+		}
+
+		if(triangles_only)
+		{
+			return true;
+		}
+
+		std::vector<Point> points;
+		std::vector<uint32_t> remaining;
+
+		faceTriangleOffsets.reserve(face_count + 1);
+		i = 1;
+		for(uint32_t face = 0; face < face_count; ++face)
+		{
+			const auto face_index_count = face_list[i];
+			auto polygon = face_list.subspan(i + 1, face_index_count);
+			for(auto index : polygon)
+			{
+				if(index >= positions.size())
+				{
+					faceTriangleOffsets.clear();
+					corners.clear();
+					return false;
+				}
+			}
+
+			faceTriangleOffsets.push_back(static_cast<uint32_t>(corners.size() / 3));
+			triangulatePolygon(positions, polygon, points, remaining, corners);
+
+			i += face_index_count + 1;
+		}
+		faceTriangleOffsets.push_back(static_cast<uint32_t>(corners.size() / 3));
+
+		return true;
+	}
+
+	bool XFileMeshTriangulation::triangulate(std::span<const uint32_t> face_list, std::vector<uint32_t> & indices) const
+	{
+		indices.clear();
+
+		if(face_list.empty())
+		{
+			return false;
+		}
+
+		const auto face_count = face_list[0];
+
+		// 三角形だけであれば，面ごとの角の数を飛ばしながらリストからそのまま写す
+		if(empty())
+		{
+			if(face_list.size() - 1 < face_count * size_t(4))
+			{
+				return false;
+			}
+
+			indices.resize(face_count * size_t(3));
+
+			auto p_face = face_list.data() + 1;
+			auto p_index = indices.data();
+			for(uint32_t face = 0; face < face_count; ++face)
+			{
+				if(p_face[0] != 3)
+				{
+					indices.clear();
+					return false;
+				}
+
+				p_index[0] = p_face[1];
+				p_index[1] = p_face[2];
+				p_index[2] = p_face[3];
+
+				p_face += 4;
+				p_index += 3;
+			}
+
+			return true;
+		}
+
+		if(faceTriangleOffsets.size() != face_count + size_t(1))
+		{
+			return false;
+		}
+
+		indices.resize(faceTriangleOffsets.back() * size_t(3));
+
+		auto p_index = indices.data();
+		size_t i = 1;
+		for(uint32_t face = 0; face < face_count; ++face)
+		{
+			if(i >= face_list.size() || face_list.size() - i - 1 < face_list[i])
+			{
+				indices.clear();
+				return false;
+			}
+
+			const auto face_index_count = face_list[i];
+			auto p_polygon = &face_list[i + 1];
+			for(auto corner = faceTriangleOffsets[face] * size_t(3); corner < faceTriangleOffsets[face + 1] * size_t(3); ++corner)
+			{
+				if(corners[corner] >= face_index_count)
+				{
+					indices.clear();
+					return false;
+				}
+
+				*p_index++ = p_polygon[corners[corner]];
+			}
+
+			i += face_index_count + 1;
+		}
+
+		return true;
+	}
+
+	void XFileMeshTriangulation::remapFaceIndexes(std::vector<uint32_t> & face_indexes) const
+	{
+		if(empty() || face_indexes.empty())
+		{
+			return;
+		}
+
+		// 面の数より少なければ，足りない面は最後のマテリアルを使う
+		std::vector<uint32_t> remapped(faceTriangleOffsets.back());
+		for(size_t face = 0; face + 1 < faceTriangleOffsets.size(); ++face)
+		{
+			auto material = face_indexes[std::min(face, face_indexes.size() - 1)];
+			std::fill(
+				remapped.begin() + faceTriangleOffsets[face],
+				remapped.begin() + faceTriangleOffsets[face + 1],
+				material
+			);
+		}
+
+		face_indexes = std::move(remapped);
+	}
+}
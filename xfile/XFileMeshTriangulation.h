@@ -0,0 +1,36 @@
+#pragma once
+#ifndef XFILE_XFILE_MESH_TRIANGULATION_H_INCLUDED
+#define XFILE_XFILE_MESH_TRIANGULATION_H_INCLUDED
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "XFileVector.h"
+
+namespace xfile
+{
+	// Meshの面の分け方．凸多角形は扇形に，凹多角形は耳を切り取って三角形に分ける
+	// MeshNormalsの面も同じ角の組み合わせで分けるので，メッシュの三角形と法線の三角形が対応する
+	struct XFileMeshTriangulation
+	{
+		// face_listは面の数，角の数，頂点番号，角の数，頂点番号…と並んだIntegerList
+		// すべて三角形であれば何も記録しない
+		bool setup(std::span<const uint32_t> face_list, std::span<const XFileVector> positions);
+
+		// setupと同じ形のface_listを三角形に分け，三角形ごとに頂点番号を3つずつindicesへ並べる
+		bool triangulate(std::span<const uint32_t> face_list, std::vector<uint32_t> & indices) const;
+
+		// 元の面ごとのマテリアルの番号を，分けてできた三角形ごとの番号にする
+		void remapFaceIndexes(std::vector<uint32_t> & face_indexes) const;
+
+		bool empty() const noexcept { return faceTriangleOffsets.empty(); }
+
+		// 元の面ごとの最初の三角形の番号．最後に三角形の数を置くので，面の数より1つ多い
+		std::vector<uint32_t> faceTriangleOffsets;
+
+		// 三角形の角が元の面の何番目の角か．三角形ごとに3つ並ぶ
+		std::vector<uint32_t> corners;
+	};
+}
+
+#endif // XFILE_XFILE_MESH_TRIANGULATION_H_INCLUDED
@@ -0,0 +1,375 @@
+#include "XFileNormalGeneration.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <span>
+#include <vector>
+#include "XFileMesh.h"
+#include "XFileThreadPool.h"
+#include "XFileVertexCorners.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define XFILE_USE_SSE2 1
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#include <arm_neon.h>
+#define XFILE_USE_NEON 1
+#endif
+
+namespace xfile
+{
+	namespace
+	{
+		// スレッドに渡す1回分の三角形と頂点の数
+		constexpr size_t ChunkTriangleCount = 4096;
+		constexpr size_t ChunkVertexCount = 4096;
+
+		struct NormalJob
+		{
+			std::span<const XFileVector> vertices;
+			std::span<const uint32_t> faceIndices;
+			XFileNormalWeighting weighting;
+			float creaseCosine;
+
+			// 以下は作業用で，ジョブを作ってから順に埋める
+			// 三角形ごとの単位法線と，角ごとの重み
+			std::vector<XFileVector> faceNormals = {};
+			std::vector<float> cornerWeights = {};
+
+			XFileVertexCorners vertexCorners = {};
+
+			// 法線を分ける場合に使う，角ごとの法線と頂点の中での法線の番号
+			std::vector<XFileVector> cornerNormals = {};
+			std::vector<uint32_t> cornerSlots = {};
+			std::vector<uint32_t> vertexNormalOffsets = {};
+		};
+
+		XFileVector normalize(float x, float y, float z) noexcept
+		{
+			float length = std::sqrt(x * x + y * y + z * z);
+			if(length > 0.0f)
+			{
+				return { x / length, y / length, z / length };
+			}
+
+			return { 0.0f, 0.0f, 0.0f };
+		}
+
+		float dot(const XFileVector & a, const XFileVector & b) noexcept
+		{
+			return a.x * b.x + a.y * b.y + a.z * b.z;
+		}
+
+		// cross_lengthは外積の長さで，三角形の面積の2倍になる
+		// dotsは角ごとの2辺の内積で，角の大きさはatan2(cross_length, dot)で求まる
+		void finishTriangle(NormalJob & job, size_t triangle, float nx, float ny, float nz, float cross_length, const float (&dots)[3])
+		{
+			auto p_weights = &job.cornerWeights[triangle * 3];
+			if(cross_length <= 0.0f)
+			{
+				job.faceNormals[triangle] = { 0.0f, 0.0f, 0.0f };
+				p_weights[0] = p_weights[1] = p_weights[2] = 0.0f;
+				return;
+			}
+
+			job.faceNormals[triangle] = { nx / cross_length, ny / cross_length, nz / cross_length };
+
+			if(job.weighting == XFileNormalWeighting::Area)
+			{
+				p_weights[0] = p_weights[1] = p_weights[2] = cross_length * 0.5f;
+			}
+			else
+			{
+				for(size_t i = 0; i < 3; ++i)
+				{
+					p_weights[i] = std::atan2(cross_length, dots[i]);
+				}
+			}
+		}
+
+		void computeFaceNormals(NormalJob & job, size_t begin, size_t end)
+		{
+			const auto * p_vertices = job.vertices.data();
+			const auto * p_indices = job.faceIndices.data();
+			size_t t = begin;
+
+#if XFILE_USE_SSE2 || XFILE_USE_NEON
+			// 4つの三角形の頂点を成分ごとに並べ替え，外積と内積をまとめて求める
+			for(; t + 4 <= end; t += 4)
+			{
+				alignas(16) float p[9][4];
+				for(size_t k = 0; k < 4; ++k)
+				{
+					auto & a = p_vertices[p_indices[(t + k) * 3 + 0]];
+					auto & b = p_vertices[p_indices[(t + k) * 3 + 1]];
+					auto & c = p_vertices[p_indices[(t + k) * 3 + 2]];
+					p[0][k] = a.x; p[1][k] = a.y; p[2][k] = a.z;
+					p[3][k] = b.x; p[4][k] = b.y; p[5][k] = b.z;
+					p[6][k] = c.x; p[7][k] = c.y; p[8][k] = c.z;
+				}
+
+				alignas(16) float r[7][4];
+#if XFILE_USE_SSE2
+				__m128 ax = _mm_load_ps(p[0]), ay = _mm_load_ps(p[1]), az = _mm_load_ps(p[2]);
+				__m128 bx = _mm_load_ps(p[3]), by = _mm_load_ps(p[4]), bz = _mm_load_ps(p[5]);
+				__m128 cx = _mm_load_ps(p[6]), cy = _mm_load_ps(p[7]), cz = _mm_load_ps(p[8]);
+
+				__m128 abx = _mm_sub_ps(bx, ax), aby = _mm_sub_ps(by, ay), abz = _mm_sub_ps(bz, az);
+				__m128 acx = _mm_sub_ps(cx, ax), acy = _mm_sub_ps(cy, ay), acz = _mm_sub_ps(cz, az);
+				__m128 bcx = _mm_sub_ps(cx, bx), bcy = _mm_sub_ps(cy, by), bcz = _mm_sub_ps(cz, bz);
+
+				__m128 nx = _mm_sub_ps(_mm_mul_ps(aby, acz), _mm_mul_ps(abz, acy));
+				__m128 ny = _mm_sub_ps(_mm_mul_ps(abz, acx), _mm_mul_ps(abx, acz));
+				__m128 nz = _mm_sub_ps(_mm_mul_ps(abx, acy), _mm_mul_ps(aby, acx));
+				__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz)));
+
+				// 角Aは(AB, AC)，角Bは(BA, BC)，角Cは(CA, CB)の内積
+				__m128 dot_a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(abx, acx), _mm_mul_ps(aby, acy)), _mm_mul_ps(abz, acz));
+				__m128 dot_b = _mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(_mm_add_ps(_mm_mul_ps(abx, bcx), _mm_mul_ps(aby, bcy)), _mm_mul_ps(abz, bcz)));
+				__m128 dot_c = _mm_add_ps(_mm_add_ps(_mm_mul_ps(acx, bcx), _mm_mul_ps(acy, bcy)), _mm_mul_ps(acz, bcz));
+
+				_mm_store_ps(r[0], nx);
+				_mm_store_ps(r[1], ny);
+				_mm_store_ps(r[2], nz);
+				_mm_store_ps(r[3], length);
+				_mm_store_ps(r[4], dot_a);
+				_mm_store_ps(r[5], dot_b);
+				_mm_store_ps(r[6], dot_c);
+#elif XFILE_USE_NEON
+				float32x4_t ax = vld1q_f32(p[0]), ay = vld1q_f32(p[1]), az = vld1q_f32(p[2]);
+				float32x4_t bx = vld1q_f32(p[3]), by = vld1q_f32(p[4]), bz = vld1q_f32(p[5]);
+				float32x4_t cx = vld1q_f32(p[6]), cy = vld1q_f32(p[7]), cz = vld1q_f32(p[8]);
+
+				float32x4_t abx = vsubq_f32(bx, ax), aby = vsubq_f32(by, ay), abz = vsubq_f32(bz, az);
+				float32x4_t acx = vsubq_f32(cx, ax), acy = vsubq_f32(cy, ay), acz = vsubq_f32(cz, az);
+				float32x4_t bcx = vsubq_f32(cx, bx), bcy = vsubq_f32(cy, by), bcz = vsubq_f32(cz, bz);
+
+				float32x4_t nx = vsubq_f32(vmulq_f32(aby, acz), vmulq_f32(abz, acy));
+				float32x4_t ny = vsubq_f32(vmulq_f32(abz, acx), vmulq_f32(abx, acz));
+				float32x4_t nz = vsubq_f32(vmulq_f32(abx, acy), vmulq_f32(aby, acx));
+				float32x4_t length = vsqrtq_f32(vaddq_f32(vaddq_f32(vmulq_f32(nx, nx), vmulq_f32(ny, ny)), vmulq_f32(nz, nz)));
+
+				float32x4_t dot_a = vaddq_f32(vaddq_f32(vmulq_f32(abx, acx), vmulq_f32(aby, acy)), vmulq_f32(abz, acz));
+				float32x4_t dot_b = vnegq_f32(vaddq_f32(vaddq_f32(vmulq_f32(abx, bcx), vmulq_f32(aby, bcy)), vmulq_f32(abz, bcz)));
+				float32x4_t dot_c = vaddq_f32(vaddq_f32(vmulq_f32(acx, bcx), vmulq_f32(acy, bcy)), vmulq_f32(acz, bcz));
+
+				vst1q_f32(r[0], nx);
+				vst1q_f32(r[1], ny);
+				vst1q_f32(r[2], nz);
+				vst1q_f32(r[3], length);
+				vst1q_f32(r[4], dot_a);
+				vst1q_f32(r[5], dot_b);
+				vst1q_f32(r[6], dot_c);
+#endif
+
+				for(size_t k = 0; k < 4; ++k)
+				{
+					const float dots[3] = { r[4][k], r[5][k], r[6][k] };
+					finishTriangle(job, t + k, r[0][k], r[1][k], r[2][k], r[3][k], dots);
+				}
+			}
+#endif
+
+			for(; t < end; ++t)
+			{
+				auto & a = p_vertices[p_indices[t * 3 + 0]];
+				auto & b = p_vertices[p_indices[t * 3 + 1]];
+				auto & c = p_vertices[p_indices[t * 3 + 2]];
+
+				XFileVector ab{ b.x - a.x, b.y - a.y, b.z - a.z };
+				XFileVector ac{ c.x - a.x, c.y - a.y, c.z - a.z };
+				XFileVector bc{ c.x - b.x, c.y - b.y, c.z - b.z };
+
+				float nx = ab.y * ac.z - ab.z * ac.y;
+				float ny = ab.z * ac.x - ab.x * ac.z;
+				float nz = ab.x * ac.y - ab.y * ac.x;
+				float length = std::sqrt(nx * nx + ny * ny + nz * nz);
+
+				const float dots[3] = { dot(ab, ac), -dot(ab, bc), dot(ac, bc) };
+				finishTriangle(job, t, nx, ny, nz, length, dots);
+			}
+		}
+
+		XFileVector sumCornerNormals(const NormalJob & job, size_t vertex, const XFileVector * p_reference)
+		{
+			float x = 0.0f;
+			float y = 0.0f;
+			float z = 0.0f;
+			for(auto corner : job.vertexCorners.corners(vertex))
+			{
+				auto & face_normal = job.faceNormals[corner / 3];
+				if(p_reference != nullptr && dot(*p_reference, face_normal) < job.creaseCosine)
+				{
+					continue;
+				}
+
+				float weight = job.cornerWeights[corner];
+				x += face_normal.x * weight;
+				y += face_normal.y * weight;
+				z += face_normal.z * weight;
+			}
+
+			return normalize(x, y, z);
+		}
+
+		void gatherVertexNormals(const NormalJob & job, std::span<XFileVector> normals, size_t begin, size_t end)
+		{
+			for(size_t v = begin; v < end; ++v)
+			{
+				normals[v] = sumCornerNormals(job, v, nullptr);
+			}
+		}
+
+		// 角ごとに，面の法線が近い角だけを足し合わせる．同じ結果になった角は1つの法線を共有する
+		void gatherCornerNormals(NormalJob & job, std::span<uint32_t> slot_counts, size_t begin, size_t end)
+		{
+			for(size_t v = begin; v < end; ++v)
+			{
+				auto corners = job.vertexCorners.corners(v);
+				uint32_t slot_count = 0;
+				for(size_t i = 0; i < corners.size(); ++i)
+				{
+					auto corner = corners[i];
+					auto & face_normal = job.faceNormals[corner / 3];
+
+					// 潰れた面は向きが無いので，頂点のすべての面を足したものを使う
+					bool degenerate = face_normal.x == 0.0f && face_normal.y == 0.0f && face_normal.z == 0.0f;
+					auto normal = sumCornerNormals(job, v, degenerate ? nullptr : &face_normal);
+					job.cornerNormals[corner] = normal;
+
+					auto slot = slot_count;
+					for(size_t j = 0; j < i; ++j)
+					{
+						auto other = corners[j];
+						if(memcmp(&job.cornerNormals[other], &normal, sizeof(normal)) == 0)
+						{
+							slot = job.cornerSlots[other];
+							break;
+						}
+					}
+
+					job.cornerSlots[corner] = slot;
+					if(slot == slot_count)
+					{
+						++slot_count;
+					}
+				}
+
+				slot_counts[v] = slot_count;
+			}
+		}
+
+		void scatterCornerNormals(const NormalJob & job, XFileMeshNormals & mesh_normals, size_t begin, size_t end)
+		{
+			for(size_t v = begin; v < end; ++v)
+			{
+				for(auto corner : job.vertexCorners.corners(v))
+				{
+					auto index = job.vertexNormalOffsets[v] + job.cornerSlots[corner];
+					mesh_normals.normals[index] = job.cornerNormals[corner];
+					mesh_normals.faceNormalIndices[corner] = index;
+				}
+			}
+		}
+	}
+
+	bool needsNormals(XFileMesh & mesh)
+	{
+		auto p_normals = mesh.findNormals();
+		if(p_normals == nullptr || p_normals->faceNormalIndices.size() != mesh.faceIndices.size())
+		{
+			return true;
+		}
+
+		for(auto & normal : p_normals->normals)
+		{
+			float length_squared = dot(normal, normal);
+			if(!std::isfinite(length_squared) || length_squared == 0.0f)
+			{
+				return true;
+			}
+		}
+
+		return std::any_of(p_normals->faceNormalIndices.begin(), p_normals->faceNormalIndices.end(), [&](uint32_t index)
+		{
+			return index >= p_normals->normals.size();
+		});
+	}
+
+	bool generateNormals(XFileMesh & mesh, const XFileNormalGenerationOptions & options, XFileThreadPool * p_thread_pool)
+	{
+		const size_t vertex_count = mesh.vertices.size();
+		const size_t corner_count = mesh.faceIndices.size();
+		const size_t triangle_count = corner_count / 3;
+		if(corner_count % 3 != 0 || corner_count > UINT32_MAX)
+		{
+			return false;
+		}
+
+		NormalJob job
+		{
+			.vertices = mesh.vertices,
+			.faceIndices = mesh.faceIndices,
+			.weighting = options.weighting,
+			.creaseCosine = std::cos(options.creaseAngle)
+		};
+
+		// 頂点ごとに角を集めておき，後で頂点ごとに足し合わせる
+		// 書き込む先が重ならないので，スレッドの間で足し合わせる順番が変わらない
+		if(!job.vertexCorners.setup(mesh.faceIndices, vertex_count))
+		{
+			return false;
+		}
+
+		job.faceNormals.resize(triangle_count);
+		job.cornerWeights.resize(corner_count);
+		parallelFor(p_thread_pool, triangle_count, ChunkTriangleCount, [&job](size_t begin, size_t end)
+		{
+			computeFaceNormals(job, begin, end);
+		});
+
+		XFileMeshNormals mesh_normals;
+		if(options.creaseAngle >= std::numbers::pi_v<float>)
+		{
+			mesh_normals.normals.resize(vertex_count);
+			mesh_normals.faceNormalIndices = mesh.faceIndices;
+			parallelFor(p_thread_pool, vertex_count, ChunkVertexCount, [&job, &mesh_normals](size_t begin, size_t end)
+			{
+				gatherVertexNormals(job, mesh_normals.normals, begin, end);
+			});
+		}
+		else
+		{
+			job.cornerNormals.resize(corner_count);
+			job.cornerSlots.resize(corner_count);
+			job.vertexNormalOffsets.resize(vertex_count + 1);
+			parallelFor(p_thread_pool, vertex_count, ChunkVertexCount, [&job](size_t begin, size_t end)
+			{
+				gatherCornerNormals(job, { job.vertexNormalOffsets.data() + 1, job.vertexNormalOffsets.size() - 1 }, begin, end);
+			});
+
+			job.vertexNormalOffsets[0] = 0;
+			for(size_t v = 0; v < vertex_count; ++v)
+			{
+				job.vertexNormalOffsets[v + 1] += job.vertexNormalOffsets[v];
+			}
+
+			mesh_normals.normals.resize(job.vertexNormalOffsets.back());
+			mesh_normals.faceNormalIndices.resize(corner_count);
+			parallelFor(p_thread_pool, vertex_count, ChunkVertexCount, [&job, &mesh_normals](size_t begin, size_t end)
+			{
+				scatterCornerNormals(job, mesh_normals, begin, end);
+			});
+		}
+
+		mesh.normals = std::move(mesh_normals);
+
+		// 読み飛ばしてあるMeshNormalsで後から上書きされないようにする
+		std::erase_if(mesh.lazyObjects, [](const XFileLazyObject & lazy_object)
+		{
+			return lazy_object.name == "MeshNormals";
+		});
+
+		return true;
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+#ifndef XFILE_XFILE_NORMAL_GENERATION_H_INCLUDED
+#define XFILE_XFILE_NORMAL_GENERATION_H_INCLUDED
+
+#include <numbers>
+
+namespace xfile
+{
+	struct XFileMesh;
+	class XFileThreadPool;
+
+	enum class XFileNormalWeighting
+	{
+		// 面の面積に比例させる
+		Area,
+		// 頂点での面の角の大きさに比例させる．分割の細かさに左右されにくい
+		Angle,
+	};
+
+	struct XFileNormalGenerationOptions
+	{
+		XFileNormalWeighting weighting = XFileNormalWeighting::Angle;
+
+		// 面の法線同士の角度がこれより大きければ，同じ頂点でも法線を分ける(ラジアン)
+		// π以上であれば分けずに頂点ごとに1つの法線にする
+		float creaseAngle = std::numbers::pi_v<float>;
+	};
+
+	// mesh.normalsが無いか使えなければtrue．読み飛ばしてあるMeshNormalsはここで読み込む
+	bool needsNormals(XFileMesh & mesh);
+
+	// mesh.verticesとmesh.faceIndicesから法線を作り，mesh.normalsを置き換える
+	// p_thread_poolを渡すと面と頂点を区切って分担する．結果はスレッドの数によらず同じになる
+	bool generateNormals(
+		XFileMesh & mesh,
+		const XFileNormalGenerationOptions & options = {},
+		XFileThreadPool * p_thread_pool = nullptr
+	);
+}
+
+#endif // XFILE_XFILE_NORMAL_GENERATION_H_INCLUDED
@@ -2,17 +2,17 @@
 #ifndef XFILE_XFILE_OBJECT_H_INCLUDED
 #define XFILE_XFILE_OBJECT_H_INCLUDED
 
-#include <vector>
-#include <string>
+#include <span>
+#include <string_view>
 #include "XFileData.h"
 
 namespace xfile
 {
 	struct XFileObject
 	{
-		std::string name;
-		std::string optionalName;
-		std::vector<XFileData> dataArray;
+		std::string_view name;
+		std::string_view optionalName;
+		std::span<const XFileData> dataArray;
 	};
 }
 
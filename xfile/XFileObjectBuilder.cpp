@@ -0,0 +1,149 @@
+#include "XFileObjectBuilder.h"
+#include <algorithm>
+#include <cstdint>
+
+namespace xfile
+{
+	XFileObjectBuilder::XFileObjectBuilder(std::pmr::memory_resource * p_upstream, XFileListStorage list_storage)
+		: mArena(p_upstream)
+		, mAllocator(&mArena)
+		, mListStorage(list_storage)
+	{
+	}
+
+	void XFileObjectBuilder::clear()
+	{
+		objects.clear();
+		mStack.clear();
+		mPendingData.clear();
+		mArena.release();
+	}
+
+	bool XFileObjectBuilder::beginObject(std::string_view name, std::string_view optional_name)
+	{
+		XFileObject * p_object = nullptr;
+		if(mStack.empty())
+		{
+			p_object = &objects.emplace_back();
+		}
+		else
+		{
+			p_object = mAllocator.new_object<XFileObject>();
+			if(!addData(DataType::Object, 1, p_object))
+			{
+				return false;
+			}
+		}
+
+		p_object->name = copyString(name);
+		p_object->optionalName = copyString(optional_name);
+		mStack.emplace_back(Frame{ p_object, mPendingData.size() });
+
+		return true;
+	}
+
+	bool XFileObjectBuilder::endObject()
+	{
+		if(mStack.empty())
+		{
+			return false;
+		}
+
+		auto frame = mStack.back();
+		mStack.pop_back();
+
+		size_t count = mPendingData.size() - frame.firstData;
+		if(count > 0)
+		{
+			auto p_data_array = mAllocator.allocate_object<XFileData>(count);
+			std::copy(mPendingData.begin() + static_cast<ptrdiff_t>(frame.firstData), mPendingData.end(), p_data_array);
+			frame.pObject->dataArray = { p_data_array, count };
+		}
+
+		mPendingData.resize(frame.firstData);
+
+		return true;
+	}
+
+	bool XFileObjectBuilder::integerList(std::span<const uint32_t> list)
+	{
+		return addList(DataType::Integer, list);
+	}
+
+	bool XFileObjectBuilder::floatList(std::span<const float> list)
+	{
+		return addList(DataType::Float, list);
+	}
+
+	bool XFileObjectBuilder::doubleList(std::span<const double> list)
+	{
+		return addList(DataType::Double, list);
+	}
+
+	bool XFileObjectBuilder::string(std::string_view s)
+	{
+		auto p_string = mAllocator.new_object<std::string_view>(copyString(s));
+
+		return addData(DataType::String, 1, p_string);
+	}
+
+	bool XFileObjectBuilder::reference(std::string_view name)
+	{
+		auto p_name = mAllocator.new_object<std::string_view>(copyString(name));
+
+		return addData(DataType::Reference, 1, p_name);
+	}
+
+	bool XFileObjectBuilder::lazyObject(const XFileLazyRange & range)
+	{
+		auto p_range = mAllocator.new_object<XFileLazyRange>(XFileLazyRange
+		{
+			.name = copyString(range.name),
+			.optionalName = copyString(range.optionalName),
+			.bytes = range.bytes,
+			.pSource = range.pSource
+		});
+
+		return addData(DataType::Lazy, 1, p_range);
+	}
+
+	std::string_view XFileObjectBuilder::copyString(std::string_view s)
+	{
+		if(s.empty())
+		{
+			return {};
+		}
+
+		auto p_chars = mAllocator.allocate_object<char>(s.size());
+		std::copy(s.begin(), s.end(), p_chars);
+
+		return { p_chars, s.size() };
+	}
+
+	bool XFileObjectBuilder::addData(DataType data_type, size_t count, const void * p_data)
+	{
+		if(mStack.empty() || count > UINT32_MAX)
+		{
+			return false;
+		}
+
+		mPendingData.emplace_back(XFileData{ data_type, static_cast<uint32_t>(count), p_data });
+
+		return true;
+	}
+
+	template <class T>
+	bool XFileObjectBuilder::addList(DataType data_type, std::span<const T> list)
+	{
+		if(mListStorage == XFileListStorage::Reference || list.empty())
+		{
+			return addData(data_type, list.size(), list.data());
+		}
+
+		// アリーナから確保するので，要素の境界にも揃う
+		auto p_list = mAllocator.allocate_object<T>(list.size());
+		std::copy(list.begin(), list.end(), p_list);
+
+		return addData(data_type, list.size(), p_list);
+	}
+}
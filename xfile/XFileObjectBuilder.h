@@ -0,0 +1,72 @@
+#pragma once
+#ifndef XFILE_XFILE_OBJECT_BUILDER_H_INCLUDED
+#define XFILE_XFILE_OBJECT_BUILDER_H_INCLUDED
+
+#include <memory_resource>
+#include <vector>
+#include "XFileObject.h"
+#include "XFileVisitor.h"
+
+namespace xfile
+{
+	enum class XFileListStorage
+	{
+		// 数値のリストをアリーナへコピーする．リーダーを閉じた後もツリーを使える
+		Copy,
+		// リーダーが渡したリストをそのまま指す．
+		// リーダーはトップレベルのオブジェクトごとやcloseでリストを解放するので，
+		// それまでにツリーを使い終える場合に限る
+		Reference,
+	};
+
+	// 通知されたデータからXFileObjectのツリーを組み立てる
+	// 名前や子の配列などツリーの中身はすべてアリーナから確保するので，
+	// clearやデストラクタでツリー全体をまとめて解放できる
+	class XFileObjectBuilder : public XFileVisitor
+	{
+	public:
+		XFileObjectBuilder(
+			std::pmr::memory_resource * p_upstream = std::pmr::get_default_resource(),
+			XFileListStorage list_storage = XFileListStorage::Copy
+		);
+
+		bool beginObject(std::string_view name, std::string_view optional_name) override;
+		bool endObject() override;
+
+		bool integerList(std::span<const uint32_t> list) override;
+		bool floatList(std::span<const float> list) override;
+		bool doubleList(std::span<const double> list) override;
+		bool string(std::string_view s) override;
+		bool reference(std::string_view name) override;
+		bool lazyObject(const XFileLazyRange & range) override;
+
+		size_t depth() const noexcept { return mStack.size(); }
+		void clear();
+
+		std::vector<XFileObject> objects;
+
+	private:
+		struct Frame
+		{
+			XFileObject * pObject;
+			size_t firstData;
+		};
+
+		std::string_view copyString(std::string_view s);
+		bool addData(DataType data_type, size_t count, const void * p_data);
+
+		template <class T>
+		bool addList(DataType data_type, std::span<const T> list);
+
+	private:
+		std::pmr::monotonic_buffer_resource mArena;
+		std::pmr::polymorphic_allocator<> mAllocator;
+		XFileListStorage mListStorage;
+		std::vector<Frame> mStack;
+
+		// 組み立て中のオブジェクトの子を積んでおき，endObjectで確定した配列をコピーする
+		std::vector<XFileData> mPendingData;
+	};
+}
+
+#endif // XFILE_XFILE_OBJECT_BUILDER_H_INCLUDED
@@ -1,6 +1,17 @@
 ﻿#include "XFileReader.h"
+#include <bit>
+#include <charconv>
+#include <future>
 #include <utility>
+#include "XFileDataCursor.h"
 #include "XFileMesh.h"
+#include "XFileObjectBuilder.h"
+#include "XFileThreadPool.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define XFILE_USE_SSE2 1
+#endif
 
 namespace
 {
@@ -8,20 +19,20 @@ namespace
 	constexpr uint32_t XFileFormatBinary = 'b' | ('i' << 8) | ('n' << 16) | (' ' << 24);
 	constexpr uint32_t XFileFormatText = 't' | ('x' << 8) | ('t' << 16) | (' ' << 24);
 	constexpr uint32_t XFileFormatCompressed = 'c' | ('m' << 8) | ('p' << 16) | (' ' << 24);
+	constexpr uint32_t XFileFormatBinaryMSZip = 'b' | ('z' << 8) | ('i' << 16) | ('p' << 24);
+	constexpr uint32_t XFileFormatTextMSZip = 't' | ('z' << 8) | ('i' << 16) | ('p' << 24);
 	constexpr uint32_t XFileFormatFloatBits32 = '0' | ('0' << 8) | ('3' << 16) | ('2' << 24);
 	constexpr uint32_t XFileFormatFloatBits64 = '0' | ('0' << 8) | ('6' << 16) | ('4' << 24);
 
-	std::istream & operator>>(std::istream & in, xfile::TokenType & token)
-	{
-		if(in.eof())
-		{
-			token = xfile::TokenType::None;
-			return in;
-		}
+	// マジック，バージョン，形式，浮動小数点数の形式
+	constexpr uint32_t XFileHeaderSize = 16;
 
-		int16_t t;
-		in.read(reinterpret_cast<char *>(&t), sizeof(t));
+	// 小さなオブジェクトごとにタスクを分けるとかえって遅くなるので，
+	// 連続するオブジェクトをこの大きさ以上にまとめてから並列に読む
+	constexpr size_t ParallelChunkSize = 64 * 1024;
 
+	xfile::TokenType toTokenType(int16_t t)
+	{
 		switch(static_cast<xfile::TokenType>(t))
 		{
 		case xfile::TokenType::Name:
@@ -55,331 +66,1927 @@ namespace
 		case xfile::TokenType::Unicode:
 		case xfile::TokenType::CString:
 		case xfile::TokenType::Array:
-			token = static_cast<xfile::TokenType>(t);
-			break;
+			return static_cast<xfile::TokenType>(t);
 		default:
-			if(in.eof()) 
-			{
-				token = xfile::TokenType::None;
-			}
-			else
+			return xfile::TokenType::Error;
+		}
+	}
+
+	// テキスト形式では空白に加えて区切り文字の','と';'も読み飛ばす
+	bool isBlank(std::byte b)
+	{
+		auto c = static_cast<unsigned char>(b);
+		return c <= ' ' || c == ',' || c == ';';
+	}
+
+	const std::byte * skipBlanks(const std::byte * p, const std::byte * p_end)
+	{
+#if XFILE_USE_SSE2
+		const __m128i space = _mm_set1_epi8(' ');
+		const __m128i comma = _mm_set1_epi8(',');
+		const __m128i semicolon = _mm_set1_epi8(';');
+
+		while(p_end - p >= 16)
+		{
+			__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+
+			// 制御文字もまとめて空白として扱うので，' '以下かどうかで判定する
+			__m128i blank = _mm_cmpeq_epi8(_mm_max_epu8(chunk, space), space);
+			blank = _mm_or_si128(blank, _mm_cmpeq_epi8(chunk, comma));
+			blank = _mm_or_si128(blank, _mm_cmpeq_epi8(chunk, semicolon));
+
+			auto mask = static_cast<uint32_t>(~_mm_movemask_epi8(blank)) & 0xffff;
+			if(mask != 0)
 			{
-				token = xfile::TokenType::Error;
+				return p + std::countr_zero(mask);
 			}
-			break;
+
+			p += 16;
+		}
+#endif
+		while(p < p_end && isBlank(*p))
+		{
+			++p;
 		}
 
-		return in;
+		return p;
 	}
-}
 
-namespace xfile
-{
-	XFileReader::XFileReader(const char * p_file_path)
+	bool isDigit(char c)
 	{
-		open(p_file_path);
+		return '0' <= c && c <= '9';
 	}
 
-	XFileReader::~XFileReader()
+	bool isNameCharacter(char c)
 	{
-		close();
+		return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || isDigit(c) || c == '_' || c == '-' || c == '.';
 	}
 
-	bool XFileReader::open(const char * p_file_path)
+	bool isNumberStart(const std::byte * p, const std::byte * p_end)
 	{
-		if(mFin.is_open())
+		auto c = static_cast<char>(*p);
+		if(isDigit(c))
 		{
-			return false;
+			return true;
 		}
 
-		mFin.open(p_file_path, std::ios::in | std::ios::binary);
-		if(!mFin)
+		if(c != '-' && c != '+' && c != '.')
 		{
 			return false;
 		}
 
-		uint32_t magic;
-		mFin.read(reinterpret_cast<char *>(&magic), sizeof(magic));
-		if(magic != XFileMagic)
+		if(p + 1 == p_end)
 		{
 			return false;
 		}
 
-		// ドキュメントではバージョンは0302となっているが，
-		// DirectX 9シェーダプログラミングブックのバージョンは0303のため
-		// いったんバージョンは無視する
-		uint32_t version;
-		mFin.read(reinterpret_cast<char *>(&version), sizeof(version));
+		auto next = static_cast<char>(p[1]);
+		return isDigit(next) || (next == '.' && c != '.');
+	}
 
-		uint32_t format;
-		mFin.read(reinterpret_cast<char *>(&format), sizeof(format));
-		switch(format)
+	// テキスト形式ではテンプレートの予約語も名前として字句解析されるので，
+	// バイナリ形式と同じトークンに読み替える
+	xfile::TokenType toKeywordTokenType(std::string_view name)
+	{
+		struct Keyword
 		{
-		case XFileFormatBinary:
-			mFormat = Format::Binary;
-			break;
-		case XFileFormatText:
-			mFormat = Format::Text;
-			break;
-		case XFileFormatCompressed:
-			mFormat = Format::Compressed;
-			break;
-		default:
-			return false;
+			std::string_view name;
+			xfile::TokenType type;
+		};
+
+		static constexpr Keyword Keywords[] =
+		{
+			{ "array", xfile::TokenType::Array },
+			{ "WORD", xfile::TokenType::Word },
+			{ "DWORD", xfile::TokenType::DoubleWord },
+			{ "FLOAT", xfile::TokenType::Float },
+			{ "DOUBLE", xfile::TokenType::Double },
+			{ "CHAR", xfile::TokenType::Char },
+			{ "UCHAR", xfile::TokenType::UnsignedChar },
+			{ "BYTE", xfile::TokenType::UnsignedChar },
+			{ "SWORD", xfile::TokenType::SignedWord },
+			{ "SDWORD", xfile::TokenType::SignedDoubleWord },
+			{ "VOID", xfile::TokenType::Void },
+			{ "STRING", xfile::TokenType::StringPointer },
+			{ "LPSTR", xfile::TokenType::StringPointer },
+			{ "UNICODE", xfile::TokenType::Unicode },
+			{ "CSTRING", xfile::TokenType::CString },
+		};
+
+		for(const auto & keyword : Keywords)
+		{
+			if(keyword.name == name)
+			{
+				return keyword.type;
+			}
 		}
 
-		uint32_t float_format;
-		mFin.read(reinterpret_cast<char *>(&float_format), sizeof(float_format));
-		switch(float_format)
+		return xfile::TokenType::Name;
+	}
+
+	bool isPrimitiveType(xfile::TokenType t)
+	{
+		return xfile::TokenType::Word <= t && t <= xfile::TokenType::CString;
+	}
+
+	// テンプレートのGUIDごとの専用のデコーダー
+	// 名前ではなくGUIDで照合するので，同じ名前の独自テンプレートは取り込まない
+	struct XFileDecoder
+	{
+		const char * pTemplateName;
+		bool (*decode)(const xfile::XFileObject & object, const xfile::XFileReader & reader, xfile::XFile & xfile);
+	};
+
+	bool decodeMesh(const xfile::XFileObject & object, const xfile::XFileReader & reader, xfile::XFile & xfile)
+	{
+		xfile::XFileMesh mesh;
+		if(!mesh.setup(object, reader.keepPreciseVertices()))
 		{
-		case XFileFormatFloatBits32:
-			mFloatFormat = FloatFormat::Bits32;
-			break;
-		case XFileFormatFloatBits64:
-			mFloatFormat = FloatFormat::Bits64;
-			break;
-		default:
 			return false;
 		}
 
+		xfile.meshes.emplace_back(std::move(mesh));
+
 		return true;
 	}
 
-	bool XFileReader::read(XFile & xfile)
+	size_t findMember(const xfile::XFileTemplate & t, const std::string & name)
 	{
+		for(size_t i = 0; i < t.members.size(); ++i)
+		{
+			if(t.members[i].name == name)
+			{
+				return i;
+			}
+		}
 
-		if(!readNextTokenType())
+		return SIZE_MAX;
+	}
+
+	bool sameLayout(const xfile::XFileTemplate & a, const xfile::XFileTemplate & b)
+	{
+		if(a.members.size() != b.members.size())
 		{
 			return false;
 		}
 
-		while(true)
+		for(size_t i = 0; i < a.members.size(); ++i)
 		{
-			XFileObject object;
-			if(!readObject(object))
+			const auto & x = a.members[i];
+			const auto & y = b.members[i];
+			if(x.type != y.type || x.typeName != y.typeName || x.dimensions.size() != y.dimensions.size())
 			{
-				break;
+				return false;
 			}
 
-			if(object.name.compare("Mesh") == 0)
+			// メンバーの名前は違ってもよいので，要素数を決めるメンバーは位置で比べる
+			for(size_t d = 0; d < x.dimensions.size(); ++d)
 			{
-				XFileMesh mesh;
-				if(!mesh.setup(object))
+				const auto & dx = x.dimensions[d];
+				const auto & dy = y.dimensions[d];
+				if(dx.memberName.empty() != dy.memberName.empty())
 				{
 					return false;
 				}
 
-				xfile.meshes.emplace_back(std::move(mesh));
+				if(dx.memberName.empty() ? dx.size != dy.size : findMember(a, dx.memberName) != findMember(b, dy.memberName))
+				{
+					return false;
+				}
 			}
+		}
 
-			if(!readNextTokenType())
+		return true;
+	}
+
+	// GUIDが一致するものに加えて，標準テンプレートと同じ名前と並びでGUIDだけが違う宣言も同じものとして扱う
+	bool matchesBuiltin(const xfile::XFileTemplate & t, const char * p_template_name)
+	{
+		auto p_builtin = xfile::XFileTemplateRegistry::builtin().find(p_template_name);
+		if(p_builtin == nullptr)
+		{
+			return false;
+		}
+
+		if(t.guid == p_builtin->guid)
+		{
+			return true;
+		}
+
+		return t.name == p_builtin->name && sameLayout(t, *p_builtin);
+	}
+
+	bool isTemplate(const xfile::XFileReader & reader, std::string_view object_name, const char * p_template_name)
+	{
+		auto p_template = reader.findTemplate(object_name);
+
+		return p_template != nullptr && matchesBuiltin(*p_template, p_template_name);
+	}
+
+	// 子のフレームは親のすぐ後ろに追加していくので，表は親が子より前に来る順に並ぶ
+	bool decodeFrame(const xfile::XFileObject & object, const xfile::XFileReader & reader, uint32_t parent, xfile::XFile & xfile)
+	{
+		auto local_matrix = xfile::identityMatrix();
+		for(const auto & data : object.dataArray)
+		{
+			auto p_child = data.object();
+			if(p_child != nullptr && isTemplate(reader, p_child->name, "FrameTransformMatrix"))
 			{
-				return false;
+				xfile::XFileDataCursor cursor(p_child->dataArray);
+				if(!cursor.readFloats(&local_matrix.m[0][0], 16))
+				{
+					return false;
+				}
+			}
+		}
+
+		auto index = xfile.frames.add(object.optionalName, parent, local_matrix);
+
+		for(const auto & data : object.dataArray)
+		{
+			auto p_child = data.object();
+			if(p_child == nullptr)
+			{
+				continue;
 			}
 
-			if(mNextTokenType == TokenType::None)
+			if(isTemplate(reader, p_child->name, "Frame"))
 			{
-				break;
+				if(!decodeFrame(*p_child, reader, index, xfile))
+				{
+					return false;
+				}
+			}
+			else if(isTemplate(reader, p_child->name, "Mesh"))
+			{
+				if(!decodeMesh(*p_child, reader, xfile))
+				{
+					return false;
+				}
+
+				xfile.meshes.back().frameIndex = index;
 			}
 		}
 
 		return true;
 	}
 
-	bool XFileReader::close()
+	bool decodeFrame(const xfile::XFileObject & object, const xfile::XFileReader & reader, xfile::XFile & xfile)
+	{
+		return decodeFrame(object, reader, xfile::XFileFrameTable::NoParent, xfile);
+	}
+
+	bool decodeAnimationSet(const xfile::XFileObject & object, const xfile::XFileReader &, xfile::XFile & xfile)
 	{
-		if(mFin.is_open())
+		xfile::XFileAnimationSet animation_set;
+		if(!animation_set.setup(object))
 		{
-			mFin.close();
+			return false;
 		}
 
+		xfile.animationSets.emplace_back(std::move(animation_set));
+
 		return true;
 	}
 
-	bool XFileReader::readObject(XFileObject & object)
+	// 取り込むのはこの3つのトップレベルのオブジェクトだけで，子のテンプレートは各setupが名前で読む
+	// どれもXFileObjectのツリーを組み立ててから読むので，メンバーの並びから直接コピーはしない
+	constexpr XFileDecoder Decoders[] =
 	{
-		if(mNextTokenType == TokenType::Name)
+		{ "Mesh", decodeMesh },
+		{ "Frame", decodeFrame },
+		{ "AnimationSet", decodeAnimationSet },
+	};
+
+	const XFileDecoder * findDecoder(const xfile::XFileTemplate & t)
+	{
+		for(const auto & decoder : Decoders)
 		{
-			if(!readName(object.name))
+			if(matchesBuiltin(t, decoder.pTemplateName))
 			{
-				return false;
+				return &decoder;
 			}
+		}
 
-			if(!readNextTokenType())
+		return nullptr;
+	}
+
+	bool hasDecoder(std::string_view template_name)
+	{
+		for(const auto & decoder : Decoders)
+		{
+			if(template_name == decoder.pTemplateName)
 			{
-				return false;
+				return true;
 			}
 		}
-		else
+
+		return false;
+	}
+
+	// トップレベルのオブジェクトを読み終わるたびにXFileへ取り込み，
+	// ツリーはすぐに破棄する．リーダーがリストを解放する前に使い終えるので，リストはコピーしない
+	class XFileLoader : public xfile::XFileObjectBuilder
+	{
+	public:
+		XFileLoader(xfile::XFile & xfile, const xfile::XFileReader & reader, std::pmr::memory_resource * p_upstream)
+			: XFileObjectBuilder(p_upstream, xfile::XFileListStorage::Reference)
+			, mXFile(xfile)
+			, mReader(reader)
 		{
-			return false;
 		}
 
-		if(mNextTokenType == TokenType::Name)
+		bool endObject() override
 		{
-			if(!readName(object.optionalName))
+			if(!XFileObjectBuilder::endObject())
 			{
 				return false;
 			}
 
-			if(!readNextTokenType())
+			if(depth() != 0)
 			{
-				return false;
+				return true;
 			}
-		}
 
-		if(mNextTokenType != TokenType::OpenBrace)
-		{
-			return false;
-		}
-
-		if(!readNextTokenType())
-		{
-			return false;
-		}
-
-		while(mNextTokenType != TokenType::CloseBrace)
-		{
-			XFileData data;
-			switch(mNextTokenType)
+			auto & object = objects.back();
+			auto p_template = mReader.findTemplate(object.name);
+			if(p_template != nullptr)
 			{
-			case TokenType::Name:
-				data.dataType = DataType::Object;
-				data.object.reset(new XFileObject);
-				if(!readObject(*data.object))
-				{
-					return false;
-				}
-				break;
-			case TokenType::IntegerList:
-				if(!readIntegerList(data))
-				{
-					return false;
-				}
-				break;
-			case TokenType::FloatList:
-				if(!readFloatList(data))
+				auto p_decoder = findDecoder(*p_template);
+				if(p_decoder != nullptr)
 				{
-					return false;
+					if(!p_decoder->decode(object, mReader, mXFile))
+					{
+						return false;
+					}
 				}
-				break;
-			case TokenType::String:
-				if(!readString(data))
+				else if(hasDecoder(p_template->name))
 				{
+					// 標準テンプレートと同じ名前で並びが違うものは読めないので，黙って捨てずに失敗にする
 					return false;
 				}
-				break;
-			default:
-				return false;
 			}
 
-			object.dataArray.emplace_back(std::move(data));
+			clear();
 
-			if(!readNextTokenType())
-			{
-				return false;
-			}
+			return true;
 		}
 
-		return true;
+	private:
+		xfile::XFile & mXFile;
+		const xfile::XFileReader & mReader;
+	};
+}
+
+namespace xfile
+{
+	XFileReader::XFileReader(const char * p_file_path)
+	{
+		open(p_file_path);
 	}
 
-	bool XFileReader::readNextTokenType()
+	XFileReader::~XFileReader()
 	{
-		mFin >> mNextTokenType;
-		if(mNextTokenType == TokenType::Error)
+		close();
+	}
+
+	bool XFileReader::open(const char * p_file_path)
+	{
+		if(mpSource || mFormat != Format::Unknown)
 		{
 			return false;
 		}
 
-		return true;
-	}
-
-	bool XFileReader::readName(std::string & s)
-	{
-		uint32_t length;
-		mFin.read(reinterpret_cast<char *>(&length), sizeof(length));
+		mpSource = std::make_shared<XFileSource>();
+		if(!mpSource->mappedFile.open(p_file_path))
+		{
+			mpSource.reset();
+			return false;
+		}
 
-		s.resize(length);
-		mFin.read(s.data(), length);
+		if(!open(mpSource->mappedFile.bytes()))
+		{
+			close();
+			return false;
+		}
 
 		return true;
 	}
 
-	bool XFileReader::readGUID()
+	bool XFileReader::open(std::span<const std::byte> bytes)
 	{
-		uint32_t data1;
-		mFin.read(reinterpret_cast<char *>(&data1), sizeof(data1));
-
-		uint16_t data2;
-		mFin.read(reinterpret_cast<char *>(&data2), sizeof(data2));
-
-		uint16_t data3;
-		mFin.read(reinterpret_cast<char *>(&data3), sizeof(data3));
+		if(mFormat != Format::Unknown)
+		{
+			return false;
+		}
 
-		uint8_t data4[8];
-		mFin.read(reinterpret_cast<char *>(data4), sizeof(data4));
+		mInput = bytes;
+		mReportedBytes = 0;
+		if(mpProgress != nullptr)
+		{
+			mpProgress->totalBytes = mInput.size();
+		}
 
-		return true;
-	}
+		mpCursor = bytes.data();
+		mpEnd = bytes.data() + bytes.size();
 
-	bool XFileReader::readIntegerList(XFileData & data)
-	{
-		uint32_t count;
-		mFin.read(reinterpret_cast<char *>(&count), sizeof(count));
+		if(!readHeader())
+		{
+			close();
+			return false;
+		}
 
-		data.dataType = DataType::Integer;
-		data.numberList.resize(count);
-		mFin.read(reinterpret_cast<char *>(data.numberList.data()), sizeof(uint32_t) * count);
+		if(!mpSource)
+		{
+			mpSource = std::make_shared<XFileSource>();
+		}
+		mpSource->text = mFormat == Format::Text;
+		mpSource->doublePrecision = mFloatFormat == FloatFormat::Bits64;
 
 		return true;
 	}
 
-	bool XFileReader::readFloatList(XFileData & data)
+	bool XFileReader::refill(size_t size)
 	{
-		uint32_t count;
-		mFin.read(reinterpret_cast<char *>(&count), sizeof(count));
+		if(static_cast<size_t>(mpEnd - mpCursor) >= size)
+		{
+			return true;
+		}
 
-		if(mFloatFormat == FloatFormat::Bits32)
+		if(!mpInflater)
 		{
-			data.dataType = DataType::Float;
-			data.floatList.resize(count);
-			mFin.read(reinterpret_cast<char *>(data.floatList.data()), sizeof(float) * count);
+			return false;
 		}
-		else if(mFloatFormat == FloatFormat::Bits64)
+
+		// 読み終わった部分を捨ててから，足りない分だけブロックを継ぎ足す
+		size_t remaining = static_cast<size_t>(mpEnd - mpCursor);
+		if(remaining > 0)
 		{
-			data.dataType = DataType::Double;
-			data.doubleList.resize(count);
-			mFin.read(reinterpret_cast<char *>(data.doubleList.data()), sizeof(double) * count);
+			memmove(mStreamBuffer.data(), mpCursor, remaining);
 		}
-		else
+		mStreamBuffer.resize(remaining);
+
+		while(mStreamBuffer.size() < size && mpInflater->next(mBlock))
 		{
-			return false;
+			mStreamBuffer.insert(mStreamBuffer.end(), mBlock.begin(), mBlock.end());
+			mInflatedSize += mBlock.size();
 		}
 
-		return true;
-	}
-	bool XFileReader::readString(XFileData & data)
-	{
-		uint32_t count;
-		mFin.read(reinterpret_cast<char *>(&count), sizeof(count));
+		mpCursor = mStreamBuffer.data();
+		mpEnd = mStreamBuffer.data() + mStreamBuffer.size();
 
-		std::string s(count, '\0');
-		mFin.read(reinterpret_cast<char *>(s.data()), count);
+		return mStreamBuffer.size() >= size;
+	}
 
-		if(!readNextTokenType())
+	size_t XFileReader::remainingBytes() const
+	{
+		size_t buffered = static_cast<size_t>(mpEnd - mpCursor);
+		if(!mpInflater)
 		{
-			return false;
+			return buffered;
 		}
 
-		if(mNextTokenType != TokenType::Comma && mNextTokenType != TokenType::SemiColon)
+		// まだ展開していない分は，ヘッダに書かれた展開後のサイズから求める
+		return buffered + (mUncompressedSize > mInflatedSize ? mUncompressedSize - mInflatedSize : 0);
+	}
+
+	bool XFileReader::skipBytes(size_t size)
+	{
+		// 大きなリストでもバッファに収める必要はないので，読めた分ずつ捨てていく
+		while(static_cast<size_t>(mpEnd - mpCursor) < size)
 		{
+			size -= static_cast<size_t>(mpEnd - mpCursor);
+			mpCursor = mpEnd;
+			if(!refill(1))
+			{
+				return false;
+			}
+		}
+
+		mpCursor += size;
+
+		return true;
+	}
+
+	bool XFileReader::readHeader()
+	{
+		uint32_t magic;
+		if(!readValue(magic) || magic != XFileMagic)
+		{
+			return false;
+		}
+
+		// ドキュメントではバージョンは0302となっているが，
+		// DirectX 9シェーダプログラミングブックのバージョンは0303のため
+		// いったんバージョンは無視する
+		uint32_t version;
+		if(!readValue(version))
+		{
+			return false;
+		}
+
+		uint32_t format;
+		if(!readValue(format))
+		{
+			return false;
+		}
+
+		bool is_compressed = false;
+		switch(format)
+		{
+		case XFileFormatBinary:
+			mFormat = Format::Binary;
+			break;
+		case XFileFormatText:
+			mFormat = Format::Text;
+			break;
+		// 古いドキュメントの"cmp "は中身の形式を示さないのでバイナリとして扱う
+		case XFileFormatCompressed:
+		case XFileFormatBinaryMSZip:
+			mFormat = Format::Binary;
+			is_compressed = true;
+			break;
+		case XFileFormatTextMSZip:
+			mFormat = Format::Text;
+			is_compressed = true;
+			break;
+		default:
+			return false;
+		}
+
+		uint32_t float_format;
+		if(!readValue(float_format))
+		{
+			return false;
+		}
+
+		switch(float_format)
+		{
+		case XFileFormatFloatBits32:
+			mFloatFormat = FloatFormat::Bits32;
+			break;
+		case XFileFormatFloatBits64:
+			mFloatFormat = FloatFormat::Bits64;
+			break;
+		default:
+			return false;
+		}
+
+		if(is_compressed)
+		{
+			// 展開後のファイルサイズはヘッダを含む．リストの要素数が残りに収まるかを調べるのに使う
+			uint32_t uncompressed_size;
+			if(!readValue(uncompressed_size) || uncompressed_size < XFileHeaderSize)
+			{
+				return false;
+			}
+			mUncompressedSize = uncompressed_size - XFileHeaderSize;
+			mInflatedSize = 0;
+
+			mCompressedOffset = static_cast<size_t>(mpCursor - mInput.data());
+			mpInflater = std::make_unique<XFileInflater>(std::span(mpCursor, mpEnd));
+			mpCursor = nullptr;
+			mpEnd = nullptr;
+		}
+
+		return true;
+	}
+
+	bool XFileReader::read(XFile & xfile)
+	{
+		XFileLoader loader(xfile, *this, mpMemoryResource != nullptr ? mpMemoryResource : std::pmr::get_default_resource());
+
+		if(!read(loader))
+		{
+			return false;
+		}
+
+		xfile.finalize();
+
+		return true;
+	}
+
+	bool XFileReader::read(XFileVisitor & visitor)
+	{
+		if(mFormat != Format::Binary && mFormat != Format::Text)
+		{
+			return false;
+		}
+
+		if(!readNextTokenType())
+		{
+			return false;
+		}
+
+		while(mNextTokenType != TokenType::None)
+		{
+			if(mNextTokenType == TokenType::Template)
+			{
+				if(!readTemplate())
+				{
+					return false;
+				}
+			}
+			else
+			{
+				if(!readObject(visitor))
+				{
+					return false;
+				}
+
+				releaseStorage();
+
+				if(mpProgress != nullptr)
+				{
+					++mpProgress->decodedObjects;
+				}
+			}
+
+			reportProgress(consumedBytes());
+
+			if(!readNextTokenType())
+			{
+				return false;
+			}
+		}
+
+		if(mpInflater && mpInflater->failed())
+		{
+			return false;
+		}
+
+		reportProgress(mInput.size());
+
+		return true;
+	}
+
+	bool XFileReader::read(XFile & xfile, XFileThreadPool & thread_pool)
+	{
+		// 展開したバッファは読み進めると再利用されるので，入力全体を参照できる場合に限る
+		if(mFormat != Format::Binary || mpInflater)
+		{
+			return read(xfile);
+		}
+
+		std::vector<std::span<const std::byte>> ranges;
+		if(!scanObjects(ranges))
+		{
+			return false;
+		}
+
+		std::vector<std::span<const std::byte>> chunks;
+		for(const auto & range : ranges)
+		{
+			if(!chunks.empty() && chunks.back().size() < ParallelChunkSize)
+			{
+				chunks.back() = { chunks.back().data(), range.data() + range.size() };
+			}
+			else
+			{
+				chunks.emplace_back(range);
+			}
+		}
+
+		std::vector<XFile> results(chunks.size());
+		std::vector<std::future<bool>> futures;
+		futures.reserve(chunks.size());
+
+		for(size_t i = 0; i < chunks.size(); ++i)
+		{
+			futures.emplace_back(thread_pool.submit([this, &chunk = chunks[i], &result = results[i]]
+			{
+				// 範囲ごとに独立したリーダーで読むので，ヘッダの情報だけ引き継ぐ
+				XFileReader reader;
+				reader.setMemoryResource(mpMemoryResource);
+				reader.mFormat = mFormat;
+				reader.mFloatFormat = mFloatFormat;
+				reader.mInput = chunk;
+				reader.mTemplates = mTemplates;
+				reader.mKeepPreciseVertices = mKeepPreciseVertices;
+				reader.mLazyMeshChildren = mLazyMeshChildren;
+				reader.mpSource = mpSource;
+				reader.mStopToken = mStopToken;
+				reader.mpProgress = mpProgress;
+				reader.mpCursor = chunk.data();
+				reader.mpEnd = chunk.data() + chunk.size();
+
+				return reader.read(result);
+			}));
+		}
+
+		// 入力を参照しているので，失敗したタスクがあってもすべて待ってから返す
+		// プールのワーカースレッドから呼ばれても止まらないように，待つ間は積まれたタスクを処理する
+		bool succeeded = true;
+		for(auto & future : futures)
+		{
+			succeeded = thread_pool.get(future) && succeeded;
+		}
+
+		if(!succeeded)
+		{
+			return false;
+		}
+
+		// 範囲に含まれないヘッダやテンプレートの分は各リーダーが数えていないので，最後に加える
+		if(mpProgress != nullptr)
+		{
+			size_t chunk_bytes = 0;
+			for(const auto & chunk : chunks)
+			{
+				chunk_bytes += chunk.size();
+			}
+
+			mpProgress->consumedBytes += mInput.size() - chunk_bytes;
+		}
+		mReportedBytes = mInput.size();
+
+		for(auto & result : results)
+		{
+			xfile.append(std::move(result));
+		}
+		xfile.finalize();
+
+		return true;
+	}
+
+	bool XFileReader::scanObjects(std::vector<std::span<const std::byte>> & ranges)
+	{
+		// リストの中身は個数から大きさが分かるので，読み飛ばして括弧の対応だけを見る
+		auto p_begin = mpCursor;
+		if(!readNextTokenType())
+		{
+			return false;
+		}
+
+		while(mNextTokenType != TokenType::None)
+		{
+			// 後ろのオブジェクトが使うかもしれないので，テンプレートは先に読んでおく
+			if(mNextTokenType == TokenType::Template)
+			{
+				if(!readTemplate())
+				{
+					return false;
+				}
+			}
+			else
+			{
+				if(!skipBlock())
+				{
+					return false;
+				}
+
+				ranges.emplace_back(p_begin, mpCursor);
+			}
+
+			p_begin = mpCursor;
+			if(!readNextTokenType())
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	const XFileTemplate * XFileReader::findTemplate(std::string_view name) const
+	{
+		auto p_template = mTemplates.find(name);
+		if(p_template != nullptr)
+		{
+			return p_template;
+		}
+
+		return XFileTemplateRegistry::builtin().find(name);
+	}
+
+	void XFileReader::setStopToken(std::stop_token stop_token)
+	{
+		mStopToken = std::move(stop_token);
+	}
+
+	void XFileReader::setProgress(XFileLoadProgress * p_progress)
+	{
+		mpProgress = p_progress;
+		if(mpProgress != nullptr)
+		{
+			mpProgress->totalBytes = mInput.size();
+		}
+	}
+
+	void XFileReader::setMemoryResource(std::pmr::memory_resource * p_resource)
+	{
+		mpMemoryResource = p_resource;
+		mpArena = std::make_unique<std::pmr::monotonic_buffer_resource>(
+			p_resource != nullptr ? p_resource : std::pmr::get_default_resource()
+		);
+	}
+
+	bool XFileReader::close()
+	{
+		mpInflater.reset();
+		mStreamBuffer.clear();
+		mBlock.clear();
+
+		mInput = {};
+		mpCursor = nullptr;
+		mpEnd = nullptr;
+		mCompressedOffset = 0;
+		mUncompressedSize = 0;
+		mInflatedSize = 0;
+		mReportedBytes = 0;
+		mFormat = Format::Unknown;
+		mFloatFormat = FloatFormat::Unknown;
+		mNextTokenType = TokenType::None;
+		mTemplates.clear();
+		releaseStorage();
+
+		// 遅延読み込みした子オブジェクトが残っていれば，ファイルはそちらが閉じる
+		mpSource.reset();
+
+		return true;
+	}
+
+	bool XFileReader::readLazyObject(const XFileLazyObject & lazy_object, XFileVisitor & visitor)
+	{
+		if(mFormat != Format::Unknown || !lazy_object.pSource)
+		{
+			return false;
+		}
+
+		mFormat = lazy_object.pSource->text ? Format::Text : Format::Binary;
+		mFloatFormat = lazy_object.pSource->doublePrecision ? FloatFormat::Bits64 : FloatFormat::Bits32;
+		mInput = lazy_object.bytes;
+		mpCursor = mInput.data();
+		mpEnd = mInput.data() + mInput.size();
+
+		if(!readNextTokenType() || mNextTokenType != TokenType::OpenBrace)
+		{
+			return false;
+		}
+
+		if(!visitor.beginObject(lazy_object.name, lazy_object.optionalName))
+		{
+			return false;
+		}
+
+		return readObjectBody(visitor, lazy_object.name);
+	}
+
+	bool XFileReader::readObject(XFileVisitor & visitor, std::string_view parent_name)
+	{
+		std::string name;
+		if(mNextTokenType == TokenType::Name)
+		{
+			if(!readName(name))
+			{
+				return false;
+			}
+
+			if(!readNextTokenType())
+			{
+				return false;
+			}
+		}
+		else
+		{
+			return false;
+		}
+
+		std::string optional_name;
+		if(mNextTokenType == TokenType::Name)
+		{
+			if(!readName(optional_name))
+			{
+				return false;
+			}
+
+			if(!readNextTokenType())
+			{
+				return false;
+			}
+		}
+
+		if(mNextTokenType != TokenType::OpenBrace)
+		{
+			return false;
+		}
+
+		if(isLazyMeshChild(name, parent_name))
+		{
+			// '{'のトークンを読んだ直後なので，その分だけ戻った位置から範囲にする
+			auto p_begin = mpCursor - (mFormat == Format::Text ? 1 : sizeof(int16_t));
+			if(!skipBlock())
+			{
+				return false;
+			}
+
+			return visitor.lazyObject(XFileLazyRange
+			{
+				.name = name,
+				.optionalName = optional_name,
+				.bytes = { p_begin, mpCursor },
+				.pSource = mpSource.get()
+			});
+		}
+
+		if(!visitor.beginObject(name, optional_name))
+		{
+			return false;
+		}
+
+		return readObjectBody(visitor, name);
+	}
+
+	bool XFileReader::readObjectBody(XFileVisitor & visitor, std::string_view name)
+	{
+		if(mFormat != Format::Text)
+		{
+			return readObjectMembers(visitor, name);
+		}
+
+		// テキスト形式では，数値の型をテンプレートのメンバーの型から決める
+		pushTextLayout(findTemplate(name));
+		bool result = readObjectMembers(visitor, name);
+		popTextLayout();
+
+		return result;
+	}
+
+	bool XFileReader::readObjectMembers(XFileVisitor & visitor, std::string_view name)
+	{
+		if(!readNextTokenType())
+		{
+			return false;
+		}
+
+		while(mNextTokenType != TokenType::CloseBrace)
+		{
+			if(mStopToken.stop_requested())
+			{
+				return false;
+			}
+
+			switch(mNextTokenType)
+			{
+			case TokenType::Name:
+				if(!readObject(visitor, name))
+				{
+					return false;
+				}
+				break;
+			case TokenType::IntegerList:
+				if(!readIntegerList(visitor))
+				{
+					return false;
+				}
+				break;
+			case TokenType::FloatList:
+				if(!readFloatList(visitor))
+				{
+					return false;
+				}
+				break;
+			case TokenType::String:
+				if(!readString(visitor))
+				{
+					return false;
+				}
+				break;
+			case TokenType::OpenBrace:
+				if(!readReference(visitor))
+				{
+					return false;
+				}
+				break;
+			case TokenType::GUID:
+			{
+				// インスタンスのクラスIDは使わない
+				XFileGUID guid;
+				if(!readGUID(guid))
+				{
+					return false;
+				}
+				break;
+			}
+			default:
+				return false;
+			}
+
+			// 大きなオブジェクトでも進み具合が分かるように，子を読むたびに知らせる
+			if(mpProgress != nullptr)
+			{
+				reportProgress(consumedBytes());
+			}
+
+			if(!readNextTokenType())
+			{
+				return false;
+			}
+		}
+
+		return visitor.endObject();
+	}
+
+	bool XFileReader::isLazyMeshChild(std::string_view name, std::string_view parent_name) const
+	{
+		// 展開用のバッファは読み進めると再利用されるので，入力全体を参照できる場合に限る
+		if(!mLazyMeshChildren || mpInflater || !mpSource)
+		{
+			return false;
+		}
+
+		if(!isTemplate(*this, parent_name, "Mesh"))
+		{
+			return false;
+		}
+
+		return isTemplate(*this, name, "MeshNormals")
+			|| isTemplate(*this, name, "MeshTextureCoords")
+			|| isTemplate(*this, name, "MeshMaterialList");
+	}
+
+	bool XFileReader::readNextTokenType()
+	{
+		if(mFormat == Format::Text)
+		{
+			return readNextTextToken();
+		}
+
+		int16_t t;
+		if(!readValue(t))
+		{
+			mNextTokenType = TokenType::None;
+			return true;
+		}
+
+		mNextTokenType = toTokenType(t);
+		if(mNextTokenType == TokenType::Error)
+		{
+			return false;
+		}
+
+		return true;
+	}
+
+	bool XFileReader::readName(std::string & s)
+	{
+		if(mFormat == Format::Text)
+		{
+			s = mTokenText;
+			return true;
+		}
+
+		uint32_t length;
+		if(!readValue(length))
+		{
+			return false;
+		}
+
+		if(!refill(length))
+		{
+			return false;
+		}
+
+		s.assign(reinterpret_cast<const char *>(mpCursor), length);
+		mpCursor += length;
+
+		return true;
+	}
+
+	bool XFileReader::readGUID(XFileGUID & guid)
+	{
+		if(mFormat == Format::Text)
+		{
+			return guid.setup(mTokenText);
+		}
+
+		return readValue(guid.data1)
+			&& readValue(guid.data2)
+			&& readValue(guid.data3)
+			&& readValue(guid.data4);
+	}
+
+	bool XFileReader::readIntegerList(XFileVisitor & visitor)
+	{
+		std::span<const uint32_t> list;
+		if(mFormat == Format::Text)
+		{
+			list = storeList<uint32_t>(mPendingIntegers.data(), mPendingIntegers.size());
+		}
+		else if(!readList(list))
+		{
+			return false;
+		}
+
+		return visitor.integerList(list);
+	}
+
+	bool XFileReader::readFloatList(XFileVisitor & visitor)
+	{
+		if(mFloatFormat == FloatFormat::Bits32)
+		{
+			std::span<const float> list;
+			if(mFormat == Format::Text)
+			{
+				list = storeList<float>(mPendingFloats.data(), mPendingFloats.size());
+			}
+			else if(!readList(list))
+			{
+				return false;
+			}
+
+			return visitor.floatList(list);
+		}
+		else if(mFloatFormat == FloatFormat::Bits64)
+		{
+			std::span<const double> list;
+			if(mFormat == Format::Text)
+			{
+				list = storeList<double>(mPendingDoubles.data(), mPendingDoubles.size());
+			}
+			else if(!readList(list))
+			{
+				return false;
+			}
+
+			return visitor.doubleList(list);
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	bool XFileReader::readString(XFileVisitor & visitor)
+	{
+		std::string s;
+		if(!readName(s))
+		{
+			return false;
+		}
+
+		// テキスト形式の区切り文字は字句解析で読み飛ばしている
+		if(mFormat == Format::Binary)
+		{
+			if(!readNextTokenType())
+			{
+				return false;
+			}
+
+			if(mNextTokenType != TokenType::Comma && mNextTokenType != TokenType::SemiColon)
+			{
+				return false;
+			}
+		}
+
+		return visitor.string(s);
+	}
+
+	bool XFileReader::readReference(XFileVisitor & visitor)
+	{
+		if(!readNextTokenType() || mNextTokenType != TokenType::Name)
+		{
+			return false;
+		}
+
+		std::string name;
+		if(!readName(name))
+		{
+			return false;
+		}
+
+		if(!readNextTokenType())
+		{
+			return false;
+		}
+
+		// 名前の後ろには参照先のGUIDが続くことがある
+		if(mNextTokenType == TokenType::GUID)
+		{
+			XFileGUID guid;
+			if(!readGUID(guid) || !readNextTokenType())
+			{
+				return false;
+			}
+		}
+
+		if(mNextTokenType != TokenType::CloseBrace)
+		{
+			return false;
+		}
+
+		return visitor.reference(name);
+	}
+
+	bool XFileReader::skipBlock()
+	{
+		if(mFormat != Format::Text)
+		{
+			return skipBlockTokens();
+		}
+
+		// 読み飛ばす数値で，外側のオブジェクトのメンバーを進めないようにする
+		pushTextLayout(nullptr);
+		bool result = skipBlockTokens();
+		popTextLayout();
+
+		return result;
+	}
+
+	bool XFileReader::skipBlockTokens()
+	{
+		// 現在のトークンから対応する'}'までを読み飛ばす
+		int32_t depth = 0;
+		while(true)
+		{
+			if(!skipTokenPayload())
+			{
+				return false;
+			}
+
+			switch(mNextTokenType)
+			{
+			case TokenType::OpenBrace:
+				++depth;
+				break;
+			case TokenType::CloseBrace:
+				if(--depth == 0)
+				{
+					return true;
+				}
+				break;
+			case TokenType::None:
+				return false;
+			default:
+				break;
+			}
+
+			if(!readNextTokenType())
+			{
+				return false;
+			}
+		}
+	}
+
+	bool XFileReader::readTemplate()
+	{
+		XFileTemplate t;
+
+		if(!readNextTokenType() || mNextTokenType != TokenType::Name)
+		{
+			return false;
+		}
+
+		if(!readName(t.name))
+		{
+			return false;
+		}
+
+		if(!readNextTokenType() || mNextTokenType != TokenType::OpenBrace)
+		{
+			return false;
+		}
+
+		if(!readNextTokenType() || mNextTokenType != TokenType::GUID)
+		{
+			return false;
+		}
+
+		if(!readGUID(t.guid))
+		{
+			return false;
+		}
+
+		if(!readTemplateTokenType())
+		{
+			return false;
+		}
+
+		while(mNextTokenType != TokenType::CloseBrace)
+		{
+			if(mNextTokenType == TokenType::OpenBracket)
+			{
+				if(!readTemplateRestriction(t))
+				{
+					return false;
+				}
+			}
+			else if(!readTemplateMember(t))
+			{
+				return false;
+			}
+		}
+
+		mTemplates.add(std::move(t));
+
+		return true;
+	}
+
+	bool XFileReader::readTemplateMember(XFileTemplate & t)
+	{
+		XFileTemplateMember member;
+
+		bool is_array = mNextTokenType == TokenType::Array;
+		if(is_array && !readTemplateTokenType())
+		{
+			return false;
+		}
+
+		if(mNextTokenType == TokenType::Name)
+		{
+			if(!readName(member.typeName))
+			{
+				return false;
+			}
+		}
+		else if(!isPrimitiveType(mNextTokenType))
+		{
+			return false;
+		}
+		member.type = mNextTokenType;
+
+		bool terminated;
+		if(!readTemplateMemberTokenType(terminated))
+		{
+			return false;
+		}
+
+		if(!terminated && mNextTokenType == TokenType::Name)
+		{
+			if(!readName(member.name) || !readTemplateMemberTokenType(terminated))
+			{
+				return false;
+			}
+		}
+
+		while(!terminated && is_array && mNextTokenType == TokenType::OpenBracket)
+		{
+			if(!readNextTokenType())
+			{
+				return false;
+			}
+
+			XFileTemplateDimension dimension;
+			if(mNextTokenType == TokenType::Name)
+			{
+				if(!readName(dimension.memberName))
+				{
+					return false;
+				}
+			}
+			else if(mNextTokenType == TokenType::Integer && mFormat == Format::Binary)
+			{
+				if(!readValue(dimension.size))
+				{
+					return false;
+				}
+			}
+			else if(mNextTokenType == TokenType::IntegerList && mFormat == Format::Text && mPendingIntegers.size() == 1)
+			{
+				dimension.size = mPendingIntegers[0];
+			}
+			else
+			{
+				return false;
+			}
+
+			if(!readNextTokenType() || mNextTokenType != TokenType::CloseBracket)
+			{
+				return false;
+			}
+
+			member.dimensions.emplace_back(std::move(dimension));
+
+			if(!readTemplateMemberTokenType(terminated))
+			{
+				return false;
+			}
+		}
+
+		if(!terminated || is_array == member.dimensions.empty())
+		{
+			return false;
+		}
+
+		t.members.emplace_back(std::move(member));
+
+		// テキスト形式では';'の次のトークンをもう読んでいる
+		if(mFormat == Format::Text)
+		{
+			if(mNextTokenType == TokenType::Name)
+			{
+				mNextTokenType = toKeywordTokenType(mTokenText);
+			}
+
+			return mNextTokenType != TokenType::None;
+		}
+
+		return readTemplateTokenType();
+	}
+
+	bool XFileReader::readTemplateMemberTokenType(bool & terminated)
+	{
+		// テキスト形式の字句解析は';'を空白として読み飛ばすので，
+		// メンバーの終わりと後ろに続く制限の'['を区別するために先に調べておく
+		if(mFormat == Format::Text)
+		{
+			while(refill(1) && static_cast<unsigned char>(*mpCursor) <= ' ')
+			{
+				++mpCursor;
+			}
+
+			terminated = refill(1) && static_cast<char>(*mpCursor) == ';';
+
+			return readNextTokenType();
+		}
+
+		if(!readNextTokenType())
+		{
+			return false;
+		}
+
+		terminated = mNextTokenType == TokenType::SemiColon;
+
+		return true;
+	}
+
+	bool XFileReader::readTemplateRestriction(XFileTemplate & t)
+	{
+		if(!readNextTokenType())
+		{
+			return false;
+		}
+
+		if(mNextTokenType == TokenType::Dot)
+		{
+			for(int i = 0; i < 2; ++i)
+			{
+				if(!readNextTokenType() || mNextTokenType != TokenType::Dot)
+				{
+					return false;
+				}
+			}
+
+			if(!readNextTokenType())
+			{
+				return false;
+			}
+
+			t.restriction = XFileTemplateRestriction::Open;
+		}
+		else
+		{
+			while(mNextTokenType != TokenType::CloseBracket)
+			{
+				switch(mNextTokenType)
+				{
+				case TokenType::Name:
+				{
+					std::string name;
+					if(!readName(name))
+					{
+						return false;
+					}
+
+					t.children.emplace_back(std::move(name));
+					break;
+				}
+				case TokenType::GUID:
+				{
+					XFileGUID guid;
+					if(!readGUID(guid))
+					{
+						return false;
+					}
+					break;
+				}
+				case TokenType::Comma:
+					break;
+				default:
+					return false;
+				}
+
+				if(!readNextTokenType())
+				{
+					return false;
+				}
+			}
+
+			t.restriction = XFileTemplateRestriction::Restricted;
+		}
+
+		if(mNextTokenType != TokenType::CloseBracket)
+		{
+			return false;
+		}
+
+		return readTemplateTokenType();
+	}
+
+	bool XFileReader::readTemplateTokenType()
+	{
+		if(!readNextTokenType())
+		{
+			return false;
+		}
+
+		if(mFormat == Format::Text && mNextTokenType == TokenType::Name)
+		{
+			mNextTokenType = toKeywordTokenType(mTokenText);
+		}
+
+		return mNextTokenType != TokenType::None;
+	}
+
+	bool XFileReader::skipTokenPayload()
+	{
+		if(mFormat == Format::Text)
+		{
+			return true;
+		}
+
+		switch(mNextTokenType)
+		{
+		case TokenType::Name:
+		case TokenType::String:
+		{
+			uint32_t length;
+			if(!readValue(length))
+			{
+				return false;
+			}
+
+			return skipBytes(length);
+		}
+		case TokenType::Integer:
+		{
+			uint32_t value;
+			return readValue(value);
+		}
+		case TokenType::GUID:
+		{
+			XFileGUID guid;
+			return readGUID(guid);
+		}
+		case TokenType::IntegerList:
+		case TokenType::FloatList:
+		{
+			uint32_t count;
+			if(!readValue(count))
+			{
+				return false;
+			}
+
+			size_t element_size = sizeof(uint32_t);
+			if(mNextTokenType == TokenType::FloatList && mFloatFormat == FloatFormat::Bits64)
+			{
+				element_size = sizeof(double);
+			}
+
+			if(count > remainingBytes() / element_size)
+			{
+				return false;
+			}
+
+			return skipBytes(element_size * count);
+		}
+		default:
+			return true;
+		}
+	}
+
+	bool XFileReader::readNextTextToken()
+	{
+		skipTextBlanks();
+
+		if(!refill(1))
+		{
+			mNextTokenType = TokenType::None;
+			return true;
+		}
+
+		auto c = static_cast<char>(*mpCursor);
+		switch(c)
+		{
+		case '{':
+			++mpCursor;
+			mNextTokenType = TokenType::OpenBrace;
+			return true;
+		case '}':
+			++mpCursor;
+			mNextTokenType = TokenType::CloseBrace;
+			return true;
+		case '[':
+			++mpCursor;
+			mNextTokenType = TokenType::OpenBracket;
+			return true;
+		case ']':
+			++mpCursor;
+			mNextTokenType = TokenType::CloseBracket;
+			return true;
+		case '<':
+			return readTextGUID();
+		case '"':
+		{
+			size_t length;
+			if(!findText('"', 1, length))
+			{
+				mNextTokenType = TokenType::Error;
+				return false;
+			}
+
+			mTokenText.assign(reinterpret_cast<const char *>(mpCursor + 1), length - 1);
+			mpCursor += length + 1;
+			mNextTokenType = TokenType::String;
+
+			if(auto p_layout = currentTextLayout())
+			{
+				p_layout->consume(XFileTextLayout::Slot::String);
+			}
+			return true;
+		}
+		default:
+			break;
+		}
+
+		// 符号や小数点の後ろまで見て数値かどうかを判定する
+		refill(2);
+
+		if(isNumberStart(mpCursor, mpEnd))
+		{
+			return readTextNumberList();
+		}
+
+		if(c == '.')
+		{
+			++mpCursor;
+			mNextTokenType = TokenType::Dot;
+			return true;
+		}
+
+		if(isNameCharacter(c))
+		{
+			size_t length = scanText(isNameCharacter);
+
+			mTokenText.assign(reinterpret_cast<const char *>(mpCursor), length);
+			mpCursor += length;
+			mNextTokenType = mTokenText.compare("template") == 0 ? TokenType::Template : TokenType::Name;
+			return true;
+		}
+
+		mNextTokenType = TokenType::Error;
+		return false;
+	}
+
+	bool XFileReader::readTextNumberList()
+	{
+		mPendingIntegers.clear();
+		mPendingFloats.clear();
+		mPendingDoubles.clear();
+
+		auto p_layout = currentTextLayout();
+
+		bool is_float_list = false;
+		size_t count = 0;
+		do
+		{
+			bool is_float = false;
+			size_t length = scanText([&is_float](char c)
+			{
+				if(c == '.' || c == 'e' || c == 'E')
+				{
+					is_float = true;
+					return true;
+				}
+
+				return isDigit(c) || c == '-' || c == '+';
+			});
+
+			// FLOATのメンバーは1や0のように書かれることもあるので，メンバーの型が分かればそれに従う
+			// 分からない場合は，小数点の有無で整数と浮動小数点数を区別する
+			// 整数のメンバーに小数が書かれていれば，見た目の通りに読み，それ以降は型を使わない
+			auto slot = p_layout != nullptr ? p_layout->next() : XFileTextLayout::Slot::Unknown;
+			if(slot == XFileTextLayout::Slot::Float)
+			{
+				is_float = true;
+			}
+
+			// 種類が切り替わったところで別のリストにする
+			if(count == 0)
+			{
+				is_float_list = is_float;
+			}
+			else if(is_float != is_float_list)
+			{
+				break;
+			}
+
+			auto p_first = reinterpret_cast<const char *>(mpCursor);
+			auto p_last = p_first + length;
+			if(*p_first == '+')
+			{
+				++p_first;
+			}
+
+			std::from_chars_result result;
+			if(is_float && mFloatFormat == FloatFormat::Bits64)
+			{
+				double value = 0.0;
+				result = std::from_chars(p_first, p_last, value);
+				mPendingDoubles.emplace_back(value);
+			}
+			else if(is_float)
+			{
+				float value = 0.0f;
+				result = std::from_chars(p_first, p_last, value);
+				mPendingFloats.emplace_back(value);
+			}
+			else if(*p_first == '-')
+			{
+				int32_t value = 0;
+				result = std::from_chars(p_first, p_last, value);
+				mPendingIntegers.emplace_back(static_cast<uint32_t>(value));
+			}
+			else
+			{
+				uint32_t value = 0;
+				result = std::from_chars(p_first, p_last, value);
+				mPendingIntegers.emplace_back(value);
+			}
+
+			if(result.ec != std::errc() || result.ptr != p_last)
+			{
+				mNextTokenType = TokenType::Error;
+				return false;
+			}
+
+			if(p_layout != nullptr)
+			{
+				p_layout->consume(
+					is_float ? XFileTextLayout::Slot::Float : XFileTextLayout::Slot::Integer,
+					is_float ? 0 : mPendingIntegers.back()
+				);
+			}
+
+			mpCursor += length;
+			++count;
+
+			skipTextBlanks();
+			refill(2);
+		}
+		while(mpCursor < mpEnd && isNumberStart(mpCursor, mpEnd));
+
+		mNextTokenType = is_float_list ? TokenType::FloatList : TokenType::IntegerList;
+
+		return true;
+	}
+
+	void XFileReader::pushTextLayout(const XFileTemplate * p_template)
+	{
+		if(mTextLayouts.size() == mTextLayoutDepth)
+		{
+			mTextLayouts.emplace_back();
+		}
+
+		mTextLayouts[mTextLayoutDepth++].reset(p_template, &mTemplates);
+	}
+
+	void XFileReader::popTextLayout()
+	{
+		--mTextLayoutDepth;
+	}
+
+	XFileTextLayout * XFileReader::currentTextLayout()
+	{
+		return mTextLayoutDepth > 0 ? &mTextLayouts[mTextLayoutDepth - 1] : nullptr;
+	}
+
+	bool XFileReader::readTextGUID()
+	{
+		size_t length;
+		if(!findText('>', 1, length))
+		{
+			mNextTokenType = TokenType::Error;
 			return false;
 		}
 
-		data.dataType = DataType::String;
-		data.stringList.emplace_back(std::move(s));
+		mTokenText.assign(reinterpret_cast<const char *>(mpCursor + 1), length - 1);
+		mpCursor += length + 1;
+		mNextTokenType = TokenType::GUID;
 
 		return true;
 	}
+
+	void XFileReader::skipTextBlanks()
+	{
+		while(true)
+		{
+			mpCursor = skipBlanks(mpCursor, mpEnd);
+			if(mpCursor == mpEnd)
+			{
+				if(!refill(1))
+				{
+					return;
+				}
+				continue;
+			}
+
+			auto c = static_cast<char>(*mpCursor);
+			if(c == '/')
+			{
+				refill(2);
+			}
+
+			bool is_comment = c == '#' || (c == '/' && mpEnd - mpCursor >= 2 && static_cast<char>(mpCursor[1]) == '/');
+			if(!is_comment)
+			{
+				return;
+			}
+
+			size_t length;
+			if(findText('\n', 0, length))
+			{
+				mpCursor += length + 1;
+			}
+			else
+			{
+				mpCursor = mpEnd;
+			}
+		}
+	}
+
+	bool XFileReader::findText(char c, size_t offset, size_t & position)
+	{
+		while(true)
+		{
+			size_t available = static_cast<size_t>(mpEnd - mpCursor);
+			if(offset < available)
+			{
+				auto p = static_cast<const std::byte *>(memchr(mpCursor + offset, c, available - offset));
+				if(p != nullptr)
+				{
+					position = static_cast<size_t>(p - mpCursor);
+					return true;
+				}
+			}
+
+			offset = available;
+			if(!refill(available + 1))
+			{
+				return false;
+			}
+		}
+	}
+
+	template <class Predicate>
+	size_t XFileReader::scanText(Predicate predicate)
+	{
+		size_t length = 0;
+		while(true)
+		{
+			while(mpCursor + length < mpEnd && predicate(static_cast<char>(mpCursor[length])))
+			{
+				++length;
+			}
+
+			// ブロックの境目で切れている場合は継ぎ足してから続きを調べる
+			if(mpCursor + length < mpEnd || !refill(length + 1))
+			{
+				return length;
+			}
+		}
+	}
+
+	void XFileReader::releaseStorage()
+	{
+		mpArena->release();
+	}
+
+	size_t XFileReader::consumedBytes() const
+	{
+		if(mpInflater)
+		{
+			// 展開後の位置は分からないので，ヘッダとブロックを渡し終えた分の合計を返す
+			return mCompressedOffset + mpInflater->consumedBytes();
+		}
+
+		if(mpCursor == nullptr)
+		{
+			return 0;
+		}
+
+		return static_cast<size_t>(mpCursor - mInput.data());
+	}
+
+	void XFileReader::reportProgress(size_t consumed_bytes)
+	{
+		if(mpProgress == nullptr)
+		{
+			return;
+		}
+
+		// 並列に読む場合は範囲ごとのリーダーが同じ進捗に加算するので，差分だけを足す
+		mpProgress->consumedBytes += consumed_bytes - mReportedBytes;
+		mReportedBytes = consumed_bytes;
+	}
 }
@@ -2,51 +2,27 @@
 #ifndef XFILE_XFILE_READER_H_INCLUDED
 #define XFILE_XFILE_READER_H_INCLUDED
 
+#include <cstddef>
 #include <cstdint>
-#include <fstream>
+#include <cstring>
+#include <span>
 #include <string>
 #include <vector>
 #include <memory>
+#include <memory_resource>
+#include <stop_token>
 #include "XFileObject.h"
 #include "XFile.h"
+#include "XFileSource.h"
+#include "XFileInflater.h"
+#include "XFileVisitor.h"
+#include "XFileLoadProgress.h"
+#include "XFileTokenType.h"
+#include "XFileTemplateRegistry.h"
+#include "XFileTextLayout.h"
 
 namespace xfile {
-	enum class TokenType
-	{
-		Error = -1,
-		None = 0,
-		Name = 1,
-		String = 2,
-		Integer = 3,
-		GUID = 5,
-		IntegerList = 6,
-		FloatList = 7,
-		OpenBrace = 10,
-		CloseBrace = 11,
-		OpenParen = 12,
-		CloseParen = 13,
-		OpenBracket = 14,
-		CloseBracket = 15,
-		OpenAngle = 16,
-		CloseAngle = 17,
-		Dot = 18,
-		Comma = 19,
-		SemiColon = 20,
-		Template = 31,
-		Word = 40,
-		DoubleWord = 41,
-		Float = 42,
-		Double = 43,
-		Char = 44,
-		UnsignedChar = 45,
-		SignedWord = 46,
-		SignedDoubleWord = 47,
-		Void = 48,
-		StringPointer = 49,
-		Unicode = 50,
-		CString = 51,
-		Array = 52
-	};
+	class XFileThreadPool;
 
 	class XFileReader
 	{
@@ -57,15 +33,52 @@ namespace xfile {
 		~XFileReader();
 
 		bool open(const char * p_file_path);
+		bool open(std::span<const std::byte> bytes);
 		bool read(XFile & xfile);
+		bool read(XFileVisitor & visitor);
+
+		// 非圧縮のバイナリ形式では，トップレベルのオブジェクトの境界を先に調べて
+		// thread_poolで並列に読み込む．結果はファイル内の順番で格納する
+		// それ以外の形式では逐次読み込みになる
+		// 待つ間は積まれたタスクを処理するので，thread_poolのワーカースレッドから呼んでもよい
+		bool read(XFile & xfile, XFileThreadPool & thread_pool);
 		bool close();
+
+		// XFileObjectのツリーやリストを置くアリーナの確保元を指定する
+		// アリーナはトップレベルのオブジェクトごとにまとめて解放する
+		// 並列に読み込む場合は各スレッドから使われるのでスレッドセーフであること
+		void setMemoryResource(std::pmr::memory_resource * p_resource);
+
+		// 停止が要求されると，読み込み中のオブジェクトの途中でもreadがfalseを返す
+		void setStopToken(std::stop_token stop_token);
+
+		// トップレベルのオブジェクトを読み終えるたびに進捗を加算する
+		void setProgress(XFileLoadProgress * p_progress);
+
+		// 64ビットのファイルで，XFileMesh::preciseVerticesに変換前の頂点座標を残す
+		void setKeepPreciseVertices(bool keep_precise_vertices) noexcept { mKeepPreciseVertices = keep_precise_vertices; }
+		bool keepPreciseVertices() const noexcept { return mKeepPreciseVertices; }
+
+		// メッシュのMeshNormals，MeshTextureCoords，MeshMaterialListを読み飛ばして範囲だけを記録し，
+		// XFileMesh::findNormalsなどで最初に使うときに読み込む
+		// 展開した入力は残らないので，圧縮形式では無視する
+		void setLazyMeshChildren(bool lazy_mesh_children) noexcept { mLazyMeshChildren = lazy_mesh_children; }
+		bool lazyMeshChildren() const noexcept { return mLazyMeshChildren; }
+
+		// 読み飛ばした子オブジェクトを1つだけ読む．開いていないリーダーで呼ぶ
+		bool readLazyObject(const XFileLazyObject & lazy_object, XFileVisitor & visitor);
+
+		// ファイル内で宣言されたテンプレート
+		const XFileTemplateRegistry & templates() const noexcept { return mTemplates; }
+
+		// ファイル内で宣言されていなければ標準テンプレートから探す
+		const XFileTemplate * findTemplate(std::string_view name) const;
 	private:
 		enum class Format
 		{
 			Unknown,
 			Binary,
 			Text,
-			Compressed,
 		};
 
 		enum class FloatFormat
@@ -76,21 +89,149 @@ namespace xfile {
 		};
 
 	private:
-		bool readObject(XFileObject & object);
+		template <class T>
+		bool readValue(T & value)
+		{
+			if(!refill(sizeof(T)))
+			{
+				return false;
+			}
+
+			memcpy(&value, mpCursor, sizeof(T));
+			mpCursor += sizeof(T);
+
+			return true;
+		}
+
+		template <class T>
+		bool readList(std::span<const T> & list)
+		{
+			uint32_t count;
+			if(!readValue(count))
+			{
+				return false;
+			}
+
+			// 32ビット環境でsizeof(T) * countが桁あふれしないように，割り算で残りと比べる
+			if(count > remainingBytes() / sizeof(T) || !refill(sizeof(T) * count))
+			{
+				return false;
+			}
+
+			// 展開用のバッファは読み進めると再利用されるので，コピーして保持する
+			// また，バイナリ形式のトークンは2バイト単位で並んでいるため，リストの先頭が
+			// 要素の境界に揃っているとは限らない．揃っていないポインタは作れないので，これもコピーする
+			if(mpInflater || reinterpret_cast<uintptr_t>(mpCursor) % alignof(T) != 0)
+			{
+				list = storeList<T>(mpCursor, count);
+			}
+			else
+			{
+				// 揃っていれば，コピーせずに入力をそのまま参照する
+				list = { reinterpret_cast<const T *>(mpCursor), count };
+			}
+			mpCursor += sizeof(T) * count;
+
+			return true;
+		}
+
+		template <class T>
+		std::span<const T> storeList(const void * p_values, size_t count)
+		{
+			if(count == 0)
+			{
+				return {};
+			}
+
+			// アリーナに確保するので，返したspanはreleaseStorageを呼ぶまで有効
+			auto p_list = static_cast<T *>(mpArena->allocate(sizeof(T) * count, alignof(T)));
+			memcpy(p_list, p_values, sizeof(T) * count);
+
+			return { p_list, count };
+		}
+
+		bool refill(size_t size);
+		bool skipBytes(size_t size);
+		size_t remainingBytes() const;
+
+		bool readHeader();
+		bool scanObjects(std::vector<std::span<const std::byte>> & ranges);
+		bool readObject(XFileVisitor & visitor, std::string_view parent_name = {});
+		bool readObjectBody(XFileVisitor & visitor, std::string_view name);
+		bool readObjectMembers(XFileVisitor & visitor, std::string_view name);
+		bool isLazyMeshChild(std::string_view name, std::string_view parent_name) const;
 		bool readNextTokenType();
 		bool readName(std::string & s);
-		bool readGUID();
-		bool readIntegerList(XFileData & data);
-		bool readFloatList(XFileData & data);
-		bool readString(XFileData & data);
+		bool readGUID(XFileGUID & guid);
+		bool readIntegerList(XFileVisitor & visitor);
+		bool readFloatList(XFileVisitor & visitor);
+		bool readString(XFileVisitor & visitor);
+		bool readReference(XFileVisitor & visitor);
+		bool skipBlock();
+		bool skipBlockTokens();
+		bool readTemplate();
+		bool readTemplateMember(XFileTemplate & t);
+		bool readTemplateMemberTokenType(bool & terminated);
+		bool readTemplateRestriction(XFileTemplate & t);
+		bool readTemplateTokenType();
+		bool skipTokenPayload();
+
+		bool readNextTextToken();
+		bool readTextNumberList();
+		void pushTextLayout(const XFileTemplate * p_template);
+		void popTextLayout();
+		XFileTextLayout * currentTextLayout();
+		bool readTextGUID();
+		void skipTextBlanks();
+		bool findText(char c, size_t offset, size_t & position);
+
+		template <class Predicate>
+		size_t scanText(Predicate predicate);
+		void releaseStorage();
+
+		size_t consumedBytes() const;
+		void reportProgress(size_t consumed_bytes);
 
 	private:
-		std::ifstream mFin;
+		std::shared_ptr<XFileSource> mpSource;
+		std::span<const std::byte> mInput;
+		const std::byte * mpCursor = nullptr;
+		const std::byte * mpEnd = nullptr;
+
+		// 圧縮形式では展開したブロックをmStreamBufferに継ぎ足しながら読む
+		std::unique_ptr<XFileInflater> mpInflater;
+		size_t mCompressedOffset = 0;
+
+		// ヘッダを除いた展開後のサイズと，これまでに展開した量
+		size_t mUncompressedSize = 0;
+		size_t mInflatedSize = 0;
+		std::vector<std::byte> mStreamBuffer;
+		std::vector<std::byte> mBlock;
+
 		Format mFormat = Format::Unknown;
 		FloatFormat mFloatFormat = FloatFormat::Unknown;
 		TokenType mNextTokenType = TokenType::None;
 
-		std::vector<XFileObject> mObjects;
+		// テキスト形式で読み込んだトークンの中身
+		std::string mTokenText;
+		std::vector<uint32_t> mPendingIntegers;
+		std::vector<float> mPendingFloats;
+		std::vector<double> mPendingDoubles;
+
+		// テキスト形式で読んでいるオブジェクトごとのメンバーの並び．確保したまま再利用する
+		std::vector<XFileTextLayout> mTextLayouts;
+		size_t mTextLayoutDepth = 0;
+
+		XFileTemplateRegistry mTemplates;
+
+		std::stop_token mStopToken;
+		XFileLoadProgress * mpProgress = nullptr;
+		bool mKeepPreciseVertices = false;
+		bool mLazyMeshChildren = false;
+		size_t mReportedBytes = 0;
+
+		std::pmr::memory_resource * mpMemoryResource = nullptr;
+		std::unique_ptr<std::pmr::monotonic_buffer_resource> mpArena = std::make_unique<std::pmr::monotonic_buffer_resource>();
 	};
 }
 
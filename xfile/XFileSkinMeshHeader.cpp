@@ -0,0 +1,30 @@
+#include "XFileSkinMeshHeader.h"
+#include "XFileDataCursor.h"
+
+namespace xfile
+{
+	bool XFileSkinMeshHeader::setup(const XFileObject & object)
+	{
+		if(object.name.compare("XSkinMeshHeader") != 0)
+		{
+			return false;
+		}
+
+		XFileDataCursor cursor(object.dataArray);
+
+		uint32_t values[3];
+		for(auto & value : values)
+		{
+			if(!cursor.readInteger(value))
+			{
+				return false;
+			}
+		}
+
+		maxSkinWeightsPerVertex = static_cast<uint16_t>(values[0]);
+		maxSkinWeightsPerFace = static_cast<uint16_t>(values[1]);
+		bones = static_cast<uint16_t>(values[2]);
+
+		return true;
+	}
+}
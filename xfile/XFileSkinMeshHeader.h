@@ -0,0 +1,20 @@
+#pragma once
+#ifndef XFILE_XFILE_SKIN_MESH_HEADER_H_INCLUDED
+#define XFILE_XFILE_SKIN_MESH_HEADER_H_INCLUDED
+
+#include <cstdint>
+#include "XFileObject.h"
+
+namespace xfile
+{
+	struct XFileSkinMeshHeader
+	{
+		bool setup(const XFileObject & object);
+
+		uint16_t maxSkinWeightsPerVertex = 0;
+		uint16_t maxSkinWeightsPerFace = 0;
+		uint16_t bones = 0;
+	};
+}
+
+#endif // XFILE_XFILE_SKIN_MESH_HEADER_H_INCLUDED
@@ -0,0 +1,50 @@
+#include "XFileSkinWeights.h"
+#include "XFileDataCursor.h"
+
+namespace xfile
+{
+	bool XFileSkinWeights::setup(const XFileObject & object)
+	{
+		if(object.name.compare("SkinWeights") != 0)
+		{
+			return false;
+		}
+
+		if(object.dataArray.empty() || object.dataArray[0].stringList().size() != 1)
+		{
+			return false;
+		}
+
+		transformNodeName = object.dataArray[0].stringList()[0];
+
+		XFileDataCursor cursor(object.dataArray.subspan(1));
+
+		uint32_t weight_count;
+		if(!cursor.readInteger(weight_count))
+		{
+			return false;
+		}
+
+		vertexIndices.resize(weight_count);
+		for(auto & vertex_index : vertexIndices)
+		{
+			if(!cursor.readInteger(vertex_index))
+			{
+				return false;
+			}
+		}
+
+		weights.resize(weight_count);
+		if(!cursor.readFloats(weights.data(), weight_count))
+		{
+			return false;
+		}
+
+		if(!cursor.readFloats(&matrixOffset.m[0][0], 16))
+		{
+			return false;
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+#ifndef XFILE_XFILE_SKIN_WEIGHTS_H_INCLUDED
+#define XFILE_XFILE_SKIN_WEIGHTS_H_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "XFileObject.h"
+#include "XFileMatrix.h"
+
+namespace xfile
+{
+	// 1本のボーンが動かす頂点とその重み
+	struct XFileSkinWeights
+	{
+		bool setup(const XFileObject & object);
+
+		std::string transformNodeName;
+
+		// transformNodeNameのフレームの番号．XFile::finalizeで決まる
+		uint32_t frameIndex = UINT32_MAX;
+
+		std::vector<uint32_t> vertexIndices;
+		std::vector<float> weights;
+
+		// メッシュの空間からボーンの空間へ移す行列
+		XFileMatrix matrixOffset;
+	};
+}
+
+#endif // XFILE_XFILE_SKIN_WEIGHTS_H_INCLUDED
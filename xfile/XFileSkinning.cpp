@@ -0,0 +1,415 @@
+#include "XFileSkinning.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "XFileFrameTable.h"
+#include "XFileMesh.h"
+#include "XFileThreadPool.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define XFILE_USE_SSE2 1
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#include <arm_neon.h>
+#define XFILE_USE_NEON 1
+#endif
+
+namespace xfile
+{
+	namespace
+	{
+		// スレッドに渡す1回分の頂点の数
+		constexpr size_t ChunkVertexCount = 4096;
+
+		// 要素の並びは(x, y, z, w)
+		struct XFileDualQuaternion
+		{
+			float real[4];
+			float dual[4];
+		};
+
+		struct SkinningJob
+		{
+			const XFileMesh & mesh;
+			std::span<const XFileMatrix> boneMatrices;
+			// デュアルクォータニオンで変形する場合に限って，変換してから入れる
+			std::span<const XFileDualQuaternion> boneDualQuaternions = {};
+			const XFileSkinningTarget & target;
+			std::span<const XFileVector> normals;
+		};
+
+		XFileDualQuaternion toDualQuaternion(const XFileMatrix & matrix) noexcept
+		{
+			// 行ベクトルに掛ける行列なので，列ベクトルの回転行列の転置として読む
+			const auto & m = matrix.m;
+			float q[4];
+			float trace = m[0][0] + m[1][1] + m[2][2];
+			if(trace > 0.0f)
+			{
+				float s = std::sqrt(trace + 1.0f) * 2.0f;
+				q[0] = (m[1][2] - m[2][1]) / s;
+				q[1] = (m[2][0] - m[0][2]) / s;
+				q[2] = (m[0][1] - m[1][0]) / s;
+				q[3] = 0.25f * s;
+			}
+			else if(m[0][0] > m[1][1] && m[0][0] > m[2][2])
+			{
+				float s = std::sqrt(1.0f + m[0][0] - m[1][1] - m[2][2]) * 2.0f;
+				q[0] = 0.25f * s;
+				q[1] = (m[1][0] + m[0][1]) / s;
+				q[2] = (m[2][0] + m[0][2]) / s;
+				q[3] = (m[1][2] - m[2][1]) / s;
+			}
+			else if(m[1][1] > m[2][2])
+			{
+				float s = std::sqrt(1.0f + m[1][1] - m[0][0] - m[2][2]) * 2.0f;
+				q[0] = (m[1][0] + m[0][1]) / s;
+				q[1] = 0.25f * s;
+				q[2] = (m[2][1] + m[1][2]) / s;
+				q[3] = (m[2][0] - m[0][2]) / s;
+			}
+			else
+			{
+				float s = std::sqrt(1.0f + m[2][2] - m[0][0] - m[1][1]) * 2.0f;
+				q[0] = (m[2][0] + m[0][2]) / s;
+				q[1] = (m[2][1] + m[1][2]) / s;
+				q[2] = 0.25f * s;
+				q[3] = (m[0][1] - m[1][0]) / s;
+			}
+
+			// 平行移動tに対して dual = 0.5 * (t, 0) * real
+			const float * t = m[3];
+			XFileDualQuaternion result;
+			memcpy(result.real, q, sizeof(q));
+			result.dual[0] = 0.5f * (q[3] * t[0] + t[1] * q[2] - t[2] * q[1]);
+			result.dual[1] = 0.5f * (q[3] * t[1] + t[2] * q[0] - t[0] * q[2]);
+			result.dual[2] = 0.5f * (q[3] * t[2] + t[0] * q[1] - t[1] * q[0]);
+			result.dual[3] = -0.5f * (t[0] * q[0] + t[1] * q[1] + t[2] * q[2]);
+
+			return result;
+		}
+
+		void writeVector(const XFileSkinningTarget & target, size_t vertex_index, size_t offset, const float * p_values) noexcept
+		{
+			auto p_vertex = static_cast<std::byte *>(target.pVertices) + target.stride * vertex_index;
+			memcpy(p_vertex + offset, p_values, sizeof(float) * 3);
+		}
+
+		void writeNormal(const XFileSkinningTarget & target, size_t vertex_index, float * p_normal) noexcept
+		{
+			float length = std::sqrt(p_normal[0] * p_normal[0] + p_normal[1] * p_normal[1] + p_normal[2] * p_normal[2]);
+			if(length > 0.0f)
+			{
+				p_normal[0] /= length;
+				p_normal[1] /= length;
+				p_normal[2] /= length;
+			}
+
+			writeVector(target, vertex_index, target.normalOffset, p_normal);
+		}
+
+		void copyBindPose(const SkinningJob & job, size_t vertex_index) noexcept
+		{
+			writeVector(job.target, vertex_index, job.target.positionOffset, &job.mesh.vertices[vertex_index].x);
+			if(job.target.normalOffset != XFileSkinningTarget::NoOffset)
+			{
+				writeVector(job.target, vertex_index, job.target.normalOffset, &job.normals[vertex_index].x);
+			}
+		}
+
+		// 重み付きの行列の和を作ってから1回だけ変換する
+		void skinLinearBlend(const SkinningJob & job, size_t begin, size_t end) noexcept
+		{
+			const bool has_normal = job.target.normalOffset != XFileSkinningTarget::NoOffset;
+
+			for(size_t i = begin; i < end; ++i)
+			{
+				const auto & influence = job.mesh.influences[i];
+
+				// 重みは大きい順に並んでいるので，先頭が0なら影響を受けない
+				if(influence.weights[0] <= 0.0f)
+				{
+					copyBindPose(job, i);
+					continue;
+				}
+
+				const auto & v = job.mesh.vertices[i];
+				alignas(16) float position[4];
+				alignas(16) float normal[4];
+
+#if XFILE_USE_SSE2
+				__m128 rows[4] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+				for(uint32_t k = 0; k < XFileVertexInfluence::MaxBones && influence.weights[k] > 0.0f; ++k)
+				{
+					const auto & m = job.boneMatrices[influence.boneIndices[k]].m;
+					__m128 weight = _mm_set1_ps(influence.weights[k]);
+					for(size_t r = 0; r < 4; ++r)
+					{
+						rows[r] = _mm_add_ps(rows[r], _mm_mul_ps(weight, _mm_loadu_ps(m[r])));
+					}
+				}
+
+				__m128 p = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(v.x), rows[0]), _mm_mul_ps(_mm_set1_ps(v.y), rows[1]));
+				p = _mm_add_ps(p, _mm_mul_ps(_mm_set1_ps(v.z), rows[2]));
+				_mm_store_ps(position, _mm_add_ps(p, rows[3]));
+
+				if(has_normal)
+				{
+					const auto & n = job.normals[i];
+					__m128 q = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(n.x), rows[0]), _mm_mul_ps(_mm_set1_ps(n.y), rows[1]));
+					_mm_store_ps(normal, _mm_add_ps(q, _mm_mul_ps(_mm_set1_ps(n.z), rows[2])));
+				}
+#elif XFILE_USE_NEON
+				float32x4_t rows[4] = { vdupq_n_f32(0.0f), vdupq_n_f32(0.0f), vdupq_n_f32(0.0f), vdupq_n_f32(0.0f) };
+				for(uint32_t k = 0; k < XFileVertexInfluence::MaxBones && influence.weights[k] > 0.0f; ++k)
+				{
+					const auto & m = job.boneMatrices[influence.boneIndices[k]].m;
+					for(size_t r = 0; r < 4; ++r)
+					{
+						rows[r] = vmlaq_n_f32(rows[r], vld1q_f32(m[r]), influence.weights[k]);
+					}
+				}
+
+				float32x4_t p = vmlaq_n_f32(rows[3], rows[0], v.x);
+				p = vmlaq_n_f32(p, rows[1], v.y);
+				vst1q_f32(position, vmlaq_n_f32(p, rows[2], v.z));
+
+				if(has_normal)
+				{
+					const auto & n = job.normals[i];
+					float32x4_t q = vmulq_n_f32(rows[0], n.x);
+					q = vmlaq_n_f32(q, rows[1], n.y);
+					vst1q_f32(normal, vmlaq_n_f32(q, rows[2], n.z));
+				}
+#else
+				XFileMatrix blended = {};
+				for(uint32_t k = 0; k < XFileVertexInfluence::MaxBones && influence.weights[k] > 0.0f; ++k)
+				{
+					const auto & m = job.boneMatrices[influence.boneIndices[k]].m;
+					for(size_t r = 0; r < 4; ++r)
+					{
+						for(size_t c = 0; c < 4; ++c)
+						{
+							blended.m[r][c] += influence.weights[k] * m[r][c];
+						}
+					}
+				}
+
+				const auto & b = blended.m;
+				for(size_t c = 0; c < 3; ++c)
+				{
+					position[c] = v.x * b[0][c] + v.y * b[1][c] + v.z * b[2][c] + b[3][c];
+				}
+
+				if(has_normal)
+				{
+					const auto & n = job.normals[i];
+					for(size_t c = 0; c < 3; ++c)
+					{
+						normal[c] = n.x * b[0][c] + n.y * b[1][c] + n.z * b[2][c];
+					}
+				}
+#endif
+
+				writeVector(job.target, i, job.target.positionOffset, position);
+
+				// 拡大縮小が一様でない場合の逆転置は行わず，正規化だけする
+				if(has_normal)
+				{
+					writeNormal(job.target, i, normal);
+				}
+			}
+		}
+
+		// 双対クォータニオンを重み付きで足し，正規化してから剛体変換として適用する
+		void skinDualQuaternion(const SkinningJob & job, size_t begin, size_t end) noexcept
+		{
+			const bool has_normal = job.target.normalOffset != XFileSkinningTarget::NoOffset;
+
+			for(size_t i = begin; i < end; ++i)
+			{
+				const auto & influence = job.mesh.influences[i];
+				if(influence.weights[0] <= 0.0f)
+				{
+					copyBindPose(job, i);
+					continue;
+				}
+
+				const auto & pivot = job.boneDualQuaternions[influence.boneIndices[0]];
+				alignas(16) float real[4];
+				alignas(16) float dual[4];
+
+#if XFILE_USE_SSE2
+				__m128 pivot_real = _mm_loadu_ps(pivot.real);
+				__m128 sum_real = _mm_setzero_ps();
+				__m128 sum_dual = _mm_setzero_ps();
+				for(uint32_t k = 0; k < XFileVertexInfluence::MaxBones && influence.weights[k] > 0.0f; ++k)
+				{
+					const auto & dq = job.boneDualQuaternions[influence.boneIndices[k]];
+					__m128 r = _mm_loadu_ps(dq.real);
+
+					// 最短経路で補間されるように，先頭のボーンと逆向きなら符号を反転する
+					alignas(16) float dots[4];
+					_mm_store_ps(dots, _mm_mul_ps(r, pivot_real));
+					float weight = (dots[0] + dots[1] + dots[2] + dots[3]) < 0.0f ? -influence.weights[k] : influence.weights[k];
+
+					__m128 w = _mm_set1_ps(weight);
+					sum_real = _mm_add_ps(sum_real, _mm_mul_ps(w, r));
+					sum_dual = _mm_add_ps(sum_dual, _mm_mul_ps(w, _mm_loadu_ps(dq.dual)));
+				}
+				_mm_store_ps(real, sum_real);
+				_mm_store_ps(dual, sum_dual);
+#elif XFILE_USE_NEON
+				float32x4_t pivot_real = vld1q_f32(pivot.real);
+				float32x4_t sum_real = vdupq_n_f32(0.0f);
+				float32x4_t sum_dual = vdupq_n_f32(0.0f);
+				for(uint32_t k = 0; k < XFileVertexInfluence::MaxBones && influence.weights[k] > 0.0f; ++k)
+				{
+					const auto & dq = job.boneDualQuaternions[influence.boneIndices[k]];
+					float32x4_t r = vld1q_f32(dq.real);
+					float weight = vaddvq_f32(vmulq_f32(r, pivot_real)) < 0.0f ? -influence.weights[k] : influence.weights[k];
+
+					sum_real = vmlaq_n_f32(sum_real, r, weight);
+					sum_dual = vmlaq_n_f32(sum_dual, vld1q_f32(dq.dual), weight);
+				}
+				vst1q_f32(real, sum_real);
+				vst1q_f32(dual, sum_dual);
+#else
+				memset(real, 0, sizeof(real));
+				memset(dual, 0, sizeof(dual));
+				for(uint32_t k = 0; k < XFileVertexInfluence::MaxBones && influence.weights[k] > 0.0f; ++k)
+				{
+					const auto & dq = job.boneDualQuaternions[influence.boneIndices[k]];
+					float dot = dq.real[0] * pivot.real[0] + dq.real[1] * pivot.real[1] + dq.real[2] * pivot.real[2] + dq.real[3] * pivot.real[3];
+					float weight = dot < 0.0f ? -influence.weights[k] : influence.weights[k];
+					for(size_t c = 0; c < 4; ++c)
+					{
+						real[c] += weight * dq.real[c];
+						dual[c] += weight * dq.dual[c];
+					}
+				}
+#endif
+
+				float length = std::sqrt(real[0] * real[0] + real[1] * real[1] + real[2] * real[2] + real[3] * real[3]);
+				for(size_t c = 0; c < 4; ++c)
+				{
+					real[c] /= length;
+					dual[c] /= length;
+				}
+
+				// 回転は p + 2 * r × (r × p + w * p)
+				auto rotate = [&real](const XFileVector & p, float * p_result)
+				{
+					float tx = real[1] * p.z - real[2] * p.y + real[3] * p.x;
+					float ty = real[2] * p.x - real[0] * p.z + real[3] * p.y;
+					float tz = real[0] * p.y - real[1] * p.x + real[3] * p.z;
+					p_result[0] = p.x + 2.0f * (real[1] * tz - real[2] * ty);
+					p_result[1] = p.y + 2.0f * (real[2] * tx - real[0] * tz);
+					p_result[2] = p.z + 2.0f * (real[0] * ty - real[1] * tx);
+				};
+
+				float position[3];
+				rotate(job.mesh.vertices[i], position);
+
+				// 平行移動は 2 * (w * d - dw * r + r × d)
+				position[0] += 2.0f * (real[3] * dual[0] - dual[3] * real[0] + real[1] * dual[2] - real[2] * dual[1]);
+				position[1] += 2.0f * (real[3] * dual[1] - dual[3] * real[1] + real[2] * dual[0] - real[0] * dual[2]);
+				position[2] += 2.0f * (real[3] * dual[2] - dual[3] * real[2] + real[0] * dual[1] - real[1] * dual[0]);
+				writeVector(job.target, i, job.target.positionOffset, position);
+
+				if(has_normal)
+				{
+					float normal[3];
+					rotate(job.normals[i], normal);
+					writeNormal(job.target, i, normal);
+				}
+			}
+		}
+	}
+
+	void computeSkinningMatrices(
+		const XFileMesh & mesh,
+		const XFileFrameTable & frames,
+		std::vector<XFileMatrix> & bone_matrices
+	)
+	{
+		bone_matrices.resize(mesh.skinWeights.size());
+		for(size_t i = 0; i < mesh.skinWeights.size(); ++i)
+		{
+			const auto & skin_weights = mesh.skinWeights[i];
+
+			// 対応するフレームが無いボーンは動かさない
+			if(skin_weights.frameIndex >= frames.size())
+			{
+				bone_matrices[i] = identityMatrix();
+				continue;
+			}
+
+			multiplyMatrix(skin_weights.matrixOffset, frames.worldMatrices[skin_weights.frameIndex], bone_matrices[i]);
+		}
+	}
+
+	bool skinVertices(
+		const XFileMesh & mesh,
+		std::span<const XFileMatrix> bone_matrices,
+		XFileSkinningMode mode,
+		const XFileSkinningTarget & target,
+		std::span<const XFileVector> normals,
+		XFileThreadPool * p_thread_pool
+	)
+	{
+		if(target.pVertices == nullptr || target.stride == 0)
+		{
+			return false;
+		}
+
+		if(target.normalOffset != XFileSkinningTarget::NoOffset && normals.size() != mesh.vertices.size())
+		{
+			return false;
+		}
+
+		std::vector<XFileDualQuaternion> dual_quaternions;
+		SkinningJob job
+		{
+			.mesh = mesh,
+			.boneMatrices = bone_matrices,
+			.target = target,
+			.normals = normals
+		};
+
+		if(mesh.influences.empty())
+		{
+			for(size_t i = 0; i < mesh.vertices.size(); ++i)
+			{
+				copyBindPose(job, i);
+			}
+
+			return true;
+		}
+
+		if(bone_matrices.size() < mesh.skinWeights.size())
+		{
+			return false;
+		}
+
+		if(mode == XFileSkinningMode::DualQuaternion)
+		{
+			dual_quaternions.resize(bone_matrices.size());
+			for(size_t i = 0; i < bone_matrices.size(); ++i)
+			{
+				dual_quaternions[i] = toDualQuaternion(bone_matrices[i]);
+			}
+			job.boneDualQuaternions = dual_quaternions;
+		}
+
+		auto skin = mode == XFileSkinningMode::DualQuaternion ? skinDualQuaternion : skinLinearBlend;
+		size_t vertex_count = mesh.vertices.size();
+
+		parallelFor(p_thread_pool, vertex_count, ChunkVertexCount, [&job, skin](size_t begin, size_t end)
+		{
+			skin(job, begin, end);
+		});
+
+		return true;
+	}
+}
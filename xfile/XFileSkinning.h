@@ -0,0 +1,57 @@
+#pragma once
+#ifndef XFILE_XFILE_SKINNING_H_INCLUDED
+#define XFILE_XFILE_SKINNING_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "XFileMatrix.h"
+#include "XFileVector.h"
+
+namespace xfile
+{
+	struct XFileMesh;
+	struct XFileFrameTable;
+	class XFileThreadPool;
+
+	enum class XFileSkinningMode
+	{
+		LinearBlend,
+		DualQuaternion,
+	};
+
+	// 書き込み先の頂点配列．strideとoffsetを合わせれば，描画用の頂点構造体へ直接書き込める
+	struct XFileSkinningTarget
+	{
+		static constexpr size_t NoOffset = SIZE_MAX;
+
+		void * pVertices = nullptr;
+		size_t stride = 0;
+		size_t positionOffset = 0;
+
+		// NoOffsetでなければ法線も変換して書き込む
+		size_t normalOffset = NoOffset;
+	};
+
+	// skinWeightsの順に，matrixOffsetとボーンのフレームのワールド行列を掛けたものを作る
+	void computeSkinningMatrices(
+		const XFileMesh & mesh,
+		const XFileFrameTable & frames,
+		std::vector<XFileMatrix> & bone_matrices
+	);
+
+	// mesh.verticesをbone_matricesで変形してtargetへ書き込む
+	// normalsは頂点ごとの法線で，target.normalOffsetを使うときだけ必要になる
+	// p_thread_poolを渡すと頂点を区切って分担する
+	bool skinVertices(
+		const XFileMesh & mesh,
+		std::span<const XFileMatrix> bone_matrices,
+		XFileSkinningMode mode,
+		const XFileSkinningTarget & target,
+		std::span<const XFileVector> normals = {},
+		XFileThreadPool * p_thread_pool = nullptr
+	);
+}
+
+#endif // XFILE_XFILE_SKINNING_H_INCLUDED
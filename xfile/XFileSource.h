@@ -0,0 +1,22 @@
+#pragma once
+#ifndef XFILE_XFILE_SOURCE_H_INCLUDED
+#define XFILE_XFILE_SOURCE_H_INCLUDED
+
+#include <memory>
+#include "XFileMappedFile.h"
+
+namespace xfile
+{
+	// XFileReaderの入力の持ち主と形式
+	// 遅延読み込みした子オブジェクトからも参照されるので，最後の参照が無くなるまでファイルを閉じない
+	struct XFileSource : std::enable_shared_from_this<XFileSource>
+	{
+		// std::spanで渡された入力の場合は開かない
+		XFileMappedFile mappedFile;
+
+		bool text = false;
+		bool doublePrecision = false;
+	};
+}
+
+#endif // XFILE_XFILE_SOURCE_H_INCLUDED
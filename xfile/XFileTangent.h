@@ -0,0 +1,17 @@
+#pragma once
+#ifndef XFILE_XFILE_TANGENT_H_INCLUDED
+#define XFILE_XFILE_TANGENT_H_INCLUDED
+
+namespace xfile
+{
+	// wは従法線の向きで1か-1になる．従法線はw * cross(normal, tangent)で求める
+	struct XFileTangent
+	{
+		float x;
+		float y;
+		float z;
+		float w;
+	};
+}
+
+#endif // XFILE_XFILE_TANGENT_H_INCLUDED
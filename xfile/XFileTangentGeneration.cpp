@@ -0,0 +1,268 @@
+#include "XFileTangentGeneration.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <span>
+#include "XFileMesh.h"
+#include "XFileThreadPool.h"
+#include "XFileVertexCorners.h"
+
+namespace xfile
+{
+	namespace
+	{
+		// スレッドに渡す1回分の三角形と頂点の数
+		constexpr size_t ChunkTriangleCount = 4096;
+		constexpr size_t ChunkVertexCount = 4096;
+
+		struct TangentJob
+		{
+			std::span<const XFileVector> vertices;
+			std::span<const XFileCoords2d> textureCoords;
+			std::span<const XFileVector> normals;
+			std::span<const uint32_t> faceIndices;
+			std::span<const uint32_t> faceNormalIndices;
+			// ここから下は，入力を確かめた後で用意する
+			XFileVertexCorners vertexCorners = {};
+
+			// 角ごとの，法線に垂直にして角の大きさを掛けた接線と，テクスチャ座標の向き
+			std::vector<XFileVector> cornerTangents = {};
+			std::vector<uint8_t> cornerOrientations = {};
+		};
+
+		XFileVector sub(const XFileVector & a, const XFileVector & b) noexcept
+		{
+			return { a.x - b.x, a.y - b.y, a.z - b.z };
+		}
+
+		XFileVector scale(const XFileVector & v, float s) noexcept
+		{
+			return { v.x * s, v.y * s, v.z * s };
+		}
+
+		float dot(const XFileVector & a, const XFileVector & b) noexcept
+		{
+			return a.x * b.x + a.y * b.y + a.z * b.z;
+		}
+
+		XFileVector normalize(const XFileVector & v) noexcept
+		{
+			float length = std::sqrt(dot(v, v));
+			return length > 0.0f ? scale(v, 1.0f / length) : XFileVector{ 0.0f, 0.0f, 0.0f };
+		}
+
+		// vから法線の成分を取り除いて正規化する
+		XFileVector project(const XFileVector & v, const XFileVector & normal) noexcept
+		{
+			return normalize(sub(v, scale(normal, dot(normal, v))));
+		}
+
+		void computeCornerTangents(TangentJob & job, size_t begin, size_t end)
+		{
+			for(size_t t = begin; t < end; ++t)
+			{
+				const uint32_t * p_indices = &job.faceIndices[t * 3];
+				const XFileVector * p_positions[3] = { &job.vertices[p_indices[0]], &job.vertices[p_indices[1]], &job.vertices[p_indices[2]] };
+				const XFileCoords2d * p_coords[3] = { &job.textureCoords[p_indices[0]], &job.textureCoords[p_indices[1]], &job.textureCoords[p_indices[2]] };
+
+				auto d1 = sub(*p_positions[1], *p_positions[0]);
+				auto d2 = sub(*p_positions[2], *p_positions[0]);
+				float t21x = p_coords[1]->u - p_coords[0]->u;
+				float t21y = p_coords[1]->v - p_coords[0]->v;
+				float t31x = p_coords[2]->u - p_coords[0]->u;
+				float t31y = p_coords[2]->v - p_coords[0]->v;
+
+				// テクスチャ座標が裏返っている面は従法線の向きを逆にする
+				float signed_area = t21x * t31y - t21y * t31x;
+				bool orientation_preserving = signed_area > 0.0f;
+
+				// テクスチャ座標が潰れている面は接線が決まらないので，同じ頂点のほかの面に任せる
+				XFileVector os{ 0.0f, 0.0f, 0.0f };
+				if(std::fabs(signed_area) > FLT_MIN)
+				{
+					os = normalize(sub(scale(d1, t31y), scale(d2, t21y)));
+					if(!orientation_preserving)
+					{
+						os = scale(os, -1.0f);
+					}
+				}
+
+				for(size_t k = 0; k < 3; ++k)
+				{
+					size_t corner = t * 3 + k;
+					auto & normal = job.normals[job.faceNormalIndices[corner]];
+
+					// 法線に垂直な平面での角の大きさで重み付けする
+					auto e1 = project(sub(*p_positions[(k + 1) % 3], *p_positions[k]), normal);
+					auto e2 = project(sub(*p_positions[(k + 2) % 3], *p_positions[k]), normal);
+					float angle = std::acos(std::clamp(dot(e1, e2), -1.0f, 1.0f));
+
+					job.cornerTangents[corner] = scale(project(os, normal), angle);
+					job.cornerOrientations[corner] = orientation_preserving ? 1 : 0;
+				}
+			}
+		}
+
+		// 2つの角の三角形が，その頂点から出る辺を共有しているか
+		// 辺のもう一方の端も頂点と法線の番号が同じ場合だけ，つながっているとみなす
+		bool sharesEdge(const TangentJob & job, uint32_t corner_a, uint32_t corner_b) noexcept
+		{
+			uint32_t triangle_a = corner_a / 3;
+			uint32_t triangle_b = corner_b / 3;
+			if(triangle_a == triangle_b)
+			{
+				return false;
+			}
+
+			for(uint32_t a = triangle_a * 3; a < triangle_a * 3 + 3; ++a)
+			{
+				if(a == corner_a)
+				{
+					continue;
+				}
+
+				for(uint32_t b = triangle_b * 3; b < triangle_b * 3 + 3; ++b)
+				{
+					if(b != corner_b && job.faceIndices[a] == job.faceIndices[b] && job.faceNormalIndices[a] == job.faceNormalIndices[b])
+					{
+						return true;
+					}
+				}
+			}
+
+			return false;
+		}
+
+		uint32_t findGroup(std::vector<uint32_t> & groups, uint32_t i) noexcept
+		{
+			while(groups[i] != i)
+			{
+				groups[i] = groups[groups[i]];
+				i = groups[i];
+			}
+			return i;
+		}
+
+		void gatherTangents(const TangentJob & job, std::span<XFileTangent> tangents, size_t begin, size_t end)
+		{
+			// 頂点ごとの角の組．区切りの中で使い回す
+			std::vector<uint32_t> groups;
+			std::vector<XFileVector> sums;
+
+			for(size_t v = begin; v < end; ++v)
+			{
+				auto corners = job.vertexCorners.corners(v);
+				const auto count = static_cast<uint32_t>(corners.size());
+
+				// MikkTSpaceと同じく，法線とテクスチャ座標の向きが同じで，辺を伝ってつながっている角を1つの組にする
+				// 離れた面が同じ頂点を使っていても，つながっていなければ接線は混ぜない
+				groups.resize(count);
+				for(uint32_t i = 0; i < count; ++i)
+				{
+					groups[i] = i;
+				}
+
+				for(uint32_t i = 0; i < count; ++i)
+				{
+					for(uint32_t j = i + 1; j < count; ++j)
+					{
+						auto corner_i = corners[i];
+						auto corner_j = corners[j];
+						if(job.faceNormalIndices[corner_i] == job.faceNormalIndices[corner_j]
+							&& job.cornerOrientations[corner_i] == job.cornerOrientations[corner_j]
+							&& sharesEdge(job, corner_i, corner_j))
+						{
+							auto group_i = findGroup(groups, i);
+							auto group_j = findGroup(groups, j);
+
+							// 小さい方へまとめておくと，組の代表は組で最初の角になる
+							groups[std::max(group_i, group_j)] = std::min(group_i, group_j);
+						}
+					}
+				}
+
+				sums.assign(count, XFileVector{ 0.0f, 0.0f, 0.0f });
+				for(uint32_t i = 0; i < count; ++i)
+				{
+					auto & sum = sums[findGroup(groups, i)];
+					auto & tangent = job.cornerTangents[corners[i]];
+					sum = { sum.x + tangent.x, sum.y + tangent.y, sum.z + tangent.z };
+				}
+
+				for(uint32_t i = 0; i < count; ++i)
+				{
+					auto group = findGroup(groups, i);
+					if(group != i)
+					{
+						tangents[corners[i]] = tangents[corners[group]];
+						continue;
+					}
+
+					auto & normal = job.normals[job.faceNormalIndices[corners[i]]];
+					auto tangent = project(sums[i], normal);
+					if(tangent.x == 0.0f && tangent.y == 0.0f && tangent.z == 0.0f)
+					{
+						// 決まらなければ法線に垂直な向きを適当に選ぶ
+						XFileVector axis = std::fabs(normal.x) < 0.9f ? XFileVector{ 1.0f, 0.0f, 0.0f } : XFileVector{ 0.0f, 1.0f, 0.0f };
+						tangent = project(axis, normal);
+					}
+
+					tangents[corners[i]] = { tangent.x, tangent.y, tangent.z, job.cornerOrientations[corners[i]] ? 1.0f : -1.0f };
+				}
+			}
+		}
+	}
+
+	bool generateTangents(XFileMesh & mesh, std::vector<XFileTangent> & tangents, XFileThreadPool * p_thread_pool)
+	{
+		auto p_normals = mesh.findNormals();
+		auto p_texture_coords = mesh.findTextureCoords();
+		if(p_normals == nullptr || p_texture_coords == nullptr)
+		{
+			return false;
+		}
+
+		const size_t corner_count = mesh.faceIndices.size();
+		if(p_normals->faceNormalIndices.size() != corner_count || p_texture_coords->textureCoords.size() != mesh.vertices.size())
+		{
+			return false;
+		}
+
+		for(auto index : p_normals->faceNormalIndices)
+		{
+			if(index >= p_normals->normals.size())
+			{
+				return false;
+			}
+		}
+
+		TangentJob job
+		{
+			.vertices = mesh.vertices,
+			.textureCoords = p_texture_coords->textureCoords,
+			.normals = p_normals->normals,
+			.faceIndices = mesh.faceIndices,
+			.faceNormalIndices = p_normals->faceNormalIndices
+		};
+
+		if(!job.vertexCorners.setup(mesh.faceIndices, mesh.vertices.size()))
+		{
+			return false;
+		}
+
+		job.cornerTangents.resize(corner_count);
+		job.cornerOrientations.resize(corner_count);
+		parallelFor(p_thread_pool, corner_count / 3, ChunkTriangleCount, [&job](size_t begin, size_t end)
+		{
+			computeCornerTangents(job, begin, end);
+		});
+
+		tangents.resize(corner_count);
+		parallelFor(p_thread_pool, mesh.vertices.size(), ChunkVertexCount, [&job, &tangents](size_t begin, size_t end)
+		{
+			gatherTangents(job, tangents, begin, end);
+		});
+
+		return true;
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+#ifndef XFILE_XFILE_TANGENT_GENERATION_H_INCLUDED
+#define XFILE_XFILE_TANGENT_GENERATION_H_INCLUDED
+
+#include <vector>
+#include "XFileTangent.h"
+
+namespace xfile
+{
+	struct XFileMesh;
+	class XFileThreadPool;
+
+	// MikkTSpaceと同じ考え方で，三角形の角ごと(mesh.faceIndicesと同じ並び)に接線を作る
+	// 頂点と法線が同じで，テクスチャ座標の向きがそろい，辺を伝ってつながっている角は同じ接線を共有する
+	// 法線とテクスチャ座標が必要なので，法線が無ければgenerateNormalsで先に作っておく
+	// p_thread_poolを渡すと三角形と頂点を区切って分担する．結果はスレッドの数によらず同じになる
+	bool generateTangents(
+		XFileMesh & mesh,
+		std::vector<XFileTangent> & tangents,
+		XFileThreadPool * p_thread_pool = nullptr
+	);
+}
+
+#endif // XFILE_XFILE_TANGENT_GENERATION_H_INCLUDED
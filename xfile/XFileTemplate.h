@@ -0,0 +1,48 @@
+#pragma once
+#ifndef XFILE_XFILE_TEMPLATE_H_INCLUDED
+#define XFILE_XFILE_TEMPLATE_H_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "XFileGUID.h"
+#include "XFileTokenType.h"
+
+namespace xfile
+{
+	// 配列の要素数は定数か，同じテンプレートのそれより前のメンバーで指定する
+	struct XFileTemplateDimension
+	{
+		uint32_t size = 0;
+		std::string memberName;
+	};
+
+	struct XFileTemplateMember
+	{
+		// 基本型はWordからCStringまでのトークン，ほかのテンプレートを使う場合はName
+		TokenType type = TokenType::None;
+		std::string typeName;
+		std::string name;
+		std::vector<XFileTemplateDimension> dimensions;
+	};
+
+	enum class XFileTemplateRestriction
+	{
+		Closed,
+		Open,
+		Restricted,
+	};
+
+	struct XFileTemplate
+	{
+		std::string name;
+		XFileGUID guid;
+		std::vector<XFileTemplateMember> members;
+
+		// Restrictedのときに子として持てるテンプレートの名前
+		XFileTemplateRestriction restriction = XFileTemplateRestriction::Closed;
+		std::vector<std::string> children;
+	};
+}
+
+#endif // XFILE_XFILE_TEMPLATE_H_INCLUDED
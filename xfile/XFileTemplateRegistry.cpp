@@ -0,0 +1,243 @@
+#include "XFileTemplateRegistry.h"
+#include <algorithm>
+#include <span>
+#include "XFileReader.h"
+
+namespace
+{
+	constexpr char BuiltinTemplates[] = R"(xof 0303txt 0032
+template Header {
+	<3D82AB43-62DA-11cf-AB39-0020AF71E433>
+	WORD major;
+	WORD minor;
+	DWORD flags;
+}
+
+template Vector {
+	<3D82AB5E-62DA-11cf-AB39-0020AF71E433>
+	FLOAT x;
+	FLOAT y;
+	FLOAT z;
+}
+
+template Coords2d {
+	<F6F23F44-7686-11cf-8F52-0040333594A3>
+	FLOAT u;
+	FLOAT v;
+}
+
+template Matrix4x4 {
+	<F6F23F45-7686-11cf-8F52-0040333594A3>
+	array FLOAT matrix[16];
+}
+
+template ColorRGBA {
+	<35FF44E0-6C7C-11cf-8F52-0040333594A3>
+	FLOAT red;
+	FLOAT green;
+	FLOAT blue;
+	FLOAT alpha;
+}
+
+template ColorRGB {
+	<D3E16E81-7835-11cf-8F52-0040333594A3>
+	FLOAT red;
+	FLOAT green;
+	FLOAT blue;
+}
+
+template IndexedColor {
+	<1630B820-7842-11cf-8F52-0040333594A3>
+	DWORD index;
+	ColorRGBA indexColor;
+}
+
+template TextureFilename {
+	<A42790E1-7810-11cf-8F52-0040333594A3>
+	STRING filename;
+}
+
+template Material {
+	<3D82AB4D-62DA-11cf-AB39-0020AF71E433>
+	ColorRGBA faceColor;
+	FLOAT power;
+	ColorRGB specularColor;
+	ColorRGB emissiveColor;
+	[...]
+}
+
+template MeshFace {
+	<3D82AB5F-62DA-11cf-AB39-0020AF71E433>
+	DWORD nFaceVertexIndices;
+	array DWORD faceVertexIndices[nFaceVertexIndices];
+}
+
+template MeshTextureCoords {
+	<F6F23F40-7686-11cf-8F52-0040333594A3>
+	DWORD nTextureCoords;
+	array Coords2d textureCoords[nTextureCoords];
+}
+
+template MeshMaterialList {
+	<F6F23F42-7686-11cf-8F52-0040333594A3>
+	DWORD nMaterials;
+	DWORD nFaceIndexes;
+	array DWORD faceIndexes[nFaceIndexes];
+	[Material <3D82AB4D-62DA-11cf-AB39-0020AF71E433>]
+}
+
+template MeshNormals {
+	<F6F23F43-7686-11cf-8F52-0040333594A3>
+	DWORD nNormals;
+	array Vector normals[nNormals];
+	DWORD nFaceNormals;
+	array MeshFace faceNormals[nFaceNormals];
+}
+
+template MeshVertexColors {
+	<1630B821-7842-11cf-8F52-0040333594A3>
+	DWORD nVertexColors;
+	array IndexedColor vertexColors[nVertexColors];
+}
+
+template Mesh {
+	<3D82AB44-62DA-11cf-AB39-0020AF71E433>
+	DWORD nVertices;
+	array Vector vertices[nVertices];
+	DWORD nFaces;
+	array MeshFace faces[nFaces];
+	[...]
+}
+
+template FrameTransformMatrix {
+	<F6F23F41-7686-11cf-8F52-0040333594A3>
+	Matrix4x4 frameMatrix;
+}
+
+template Frame {
+	<3D82AB46-62DA-11cf-AB39-0020AF71E433>
+	[...]
+}
+
+template FloatKeys {
+	<10DD46A9-775B-11cf-8F52-0040333594A3>
+	DWORD nValues;
+	array FLOAT values[nValues];
+}
+
+template TimedFloatKeys {
+	<F406B180-7B3B-11cf-8F52-0040333594A3>
+	DWORD time;
+	FloatKeys tfkeys;
+}
+
+template AnimationKey {
+	<10DD46A8-775B-11cf-8F52-0040333594A3>
+	DWORD keyType;
+	DWORD nKeys;
+	array TimedFloatKeys keys[nKeys];
+}
+
+template AnimationOptions {
+	<E2BF56C0-840F-11cf-8F52-0040333594A3>
+	DWORD openclosed;
+	DWORD positionquality;
+}
+
+template Animation {
+	<3D82AB4F-62DA-11cf-AB39-0020AF71E433>
+	[...]
+}
+
+template AnimationSet {
+	<3D82AB50-62DA-11cf-AB39-0020AF71E433>
+	[Animation <3D82AB4F-62DA-11cf-AB39-0020AF71E433>]
+}
+
+template XSkinMeshHeader {
+	<3CF169CE-FF7C-44ab-93C0-F78F62D172E2>
+	WORD nMaxSkinWeightsPerVertex;
+	WORD nMaxSkinWeightsPerFace;
+	WORD nBones;
+}
+
+template SkinWeights {
+	<6F0D123B-BAD2-4167-A0D0-80224F25FABB>
+	STRING transformNodeName;
+	DWORD nWeights;
+	array DWORD vertexIndices[nWeights];
+	array FLOAT weights[nWeights];
+	Matrix4x4 matrixOffset;
+}
+)";
+
+	// テンプレートの宣言だけを読むので，オブジェクトは何もせずに読み飛ばす
+	class NullVisitor : public xfile::XFileVisitor
+	{
+	public:
+		bool beginObject(std::string_view, std::string_view) override { return true; }
+		bool endObject() override { return true; }
+	};
+}
+
+namespace xfile
+{
+	void XFileTemplateRegistry::add(XFileTemplate && t)
+	{
+		auto it = mIndices.find(t.name);
+		if(it != mIndices.end())
+		{
+			mTemplates[it->second] = std::move(t);
+			return;
+		}
+
+		mIndices.emplace(t.name, mTemplates.size());
+		mTemplates.emplace_back(std::move(t));
+	}
+
+	void XFileTemplateRegistry::clear()
+	{
+		mTemplates.clear();
+		mIndices.clear();
+	}
+
+	const XFileTemplate * XFileTemplateRegistry::find(std::string_view name) const
+	{
+		auto it = mIndices.find(name);
+		if(it == mIndices.end())
+		{
+			return nullptr;
+		}
+
+		return &mTemplates[it->second];
+	}
+
+	const XFileTemplate * XFileTemplateRegistry::find(const XFileGUID & guid) const
+	{
+		auto it = std::find_if(mTemplates.begin(), mTemplates.end(), [&guid](const XFileTemplate & t)
+		{
+			return t.guid == guid;
+		});
+
+		return it != mTemplates.end() ? &*it : nullptr;
+	}
+
+	const XFileTemplateRegistry & XFileTemplateRegistry::builtin()
+	{
+		static const XFileTemplateRegistry registry = []
+		{
+			XFileReader reader;
+			NullVisitor visitor;
+
+			auto bytes = std::as_bytes(std::span(BuiltinTemplates, sizeof(BuiltinTemplates) - 1));
+			if(!reader.open(bytes) || !reader.read(visitor))
+			{
+				return XFileTemplateRegistry();
+			}
+
+			return reader.templates();
+		}();
+
+		return registry;
+	}
+}
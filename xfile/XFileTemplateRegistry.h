@@ -0,0 +1,35 @@
+#pragma once
+#ifndef XFILE_XFILE_TEMPLATE_REGISTRY_H_INCLUDED
+#define XFILE_XFILE_TEMPLATE_REGISTRY_H_INCLUDED
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "XFileTemplate.h"
+
+namespace xfile
+{
+	// テンプレートを名前とGUIDで引けるようにまとめる
+	// 同じ名前のテンプレートを追加すると後から追加したもので置き換える
+	class XFileTemplateRegistry
+	{
+	public:
+		void add(XFileTemplate && t);
+		void clear();
+
+		const XFileTemplate * find(std::string_view name) const;
+		const XFileTemplate * find(const XFileGUID & guid) const;
+
+		size_t size() const noexcept { return mTemplates.size(); }
+
+		// DirectXの標準テンプレート(rmxftmpl.x)
+		static const XFileTemplateRegistry & builtin();
+
+	private:
+		std::vector<XFileTemplate> mTemplates;
+		std::map<std::string, size_t, std::less<>> mIndices;
+	};
+}
+
+#endif // XFILE_XFILE_TEMPLATE_REGISTRY_H_INCLUDED
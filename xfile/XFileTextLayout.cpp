@@ -0,0 +1,189 @@
+#include "XFileTextLayout.h"
+
+namespace
+{
+	// 自分自身をメンバーに持つような壊れたテンプレートで止まらないようにする
+	constexpr size_t MaxDepth = 64;
+}
+
+namespace xfile
+{
+	void XFileTextLayout::reset(const XFileTemplate * p_template, const XFileTemplateRegistry * p_file_templates)
+	{
+		mpFileTemplates = p_file_templates;
+		mDepth = 0;
+		mBroken = p_template == nullptr;
+
+		if(p_template != nullptr)
+		{
+			pushFrame(p_template);
+		}
+	}
+
+	XFileTextLayout::Slot XFileTextLayout::next()
+	{
+		while(!mBroken && mDepth > 0)
+		{
+			auto & frame = mFrames[mDepth - 1];
+			if(frame.member == frame.pTemplate->members.size())
+			{
+				// オブジェクト自身のメンバーを読み終えたら，後ろは子のオブジェクトになる
+				if(mDepth == 1)
+				{
+					return Slot::Unknown;
+				}
+
+				--mDepth;
+				finishElement();
+				continue;
+			}
+
+			if(frame.remaining == 0)
+			{
+				if(!enterMember(frame))
+				{
+					mBroken = true;
+					break;
+				}
+
+				if(frame.remaining == 0)
+				{
+					++frame.member;
+					continue;
+				}
+			}
+
+			const auto & member = frame.pTemplate->members[frame.member];
+			switch(member.type)
+			{
+			case TokenType::Name:
+			{
+				auto p_template = findTemplate(member.typeName);
+				if(p_template == nullptr || mDepth == MaxDepth)
+				{
+					mBroken = true;
+					break;
+				}
+
+				// frameはここで無効になることがあるので，次の周回で取り直す
+				pushFrame(p_template);
+				continue;
+			}
+			case TokenType::Float:
+			case TokenType::Double:
+				return Slot::Float;
+			case TokenType::StringPointer:
+			case TokenType::Unicode:
+			case TokenType::CString:
+				return Slot::String;
+			case TokenType::Void:
+				mBroken = true;
+				break;
+			default:
+				return Slot::Integer;
+			}
+		}
+
+		return Slot::Unknown;
+	}
+
+	void XFileTextLayout::consume(Slot slot, uint32_t integer_value)
+	{
+		if(mBroken)
+		{
+			return;
+		}
+
+		if(slot == Slot::Unknown || next() != slot)
+		{
+			mBroken = true;
+			return;
+		}
+
+		auto & frame = mFrames[mDepth - 1];
+		if(slot == Slot::Integer && frame.pTemplate->members[frame.member].dimensions.empty())
+		{
+			frame.values[frame.member] = integer_value;
+		}
+
+		if(--frame.remaining == 0)
+		{
+			++frame.member;
+		}
+	}
+
+	const XFileTemplate * XFileTextLayout::findTemplate(const std::string & name) const
+	{
+		if(mpFileTemplates != nullptr)
+		{
+			auto p_template = mpFileTemplates->find(name);
+			if(p_template != nullptr)
+			{
+				return p_template;
+			}
+		}
+
+		return XFileTemplateRegistry::builtin().find(name);
+	}
+
+	bool XFileTextLayout::enterMember(Frame & frame)
+	{
+		const auto & members = frame.pTemplate->members;
+		const auto & member = members[frame.member];
+
+		uint64_t count = 1;
+		for(const auto & dimension : member.dimensions)
+		{
+			uint64_t size = dimension.size;
+			if(!dimension.memberName.empty())
+			{
+				// 要素数に使えるのは，それより前のメンバーだけ
+				size_t i = 0;
+				while(i < frame.member && members[i].name != dimension.memberName)
+				{
+					++i;
+				}
+
+				if(i == frame.member)
+				{
+					return false;
+				}
+
+				size = frame.values[i];
+			}
+
+			if(size != 0 && count > UINT64_MAX / size)
+			{
+				return false;
+			}
+			count *= size;
+		}
+
+		frame.remaining = count;
+
+		return true;
+	}
+
+	void XFileTextLayout::pushFrame(const XFileTemplate * p_template)
+	{
+		if(mFrames.size() == mDepth)
+		{
+			mFrames.emplace_back();
+		}
+
+		auto & frame = mFrames[mDepth++];
+		frame.pTemplate = p_template;
+		frame.member = 0;
+		frame.remaining = 0;
+		frame.values.assign(p_template->members.size(), 0);
+	}
+
+	void XFileTextLayout::finishElement()
+	{
+		auto & frame = mFrames[mDepth - 1];
+		if(--frame.remaining == 0)
+		{
+			++frame.member;
+		}
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+#ifndef XFILE_XFILE_TEXT_LAYOUT_H_INCLUDED
+#define XFILE_XFILE_TEXT_LAYOUT_H_INCLUDED
+
+#include <cstdint>
+#include <vector>
+#include "XFileTemplate.h"
+#include "XFileTemplateRegistry.h"
+
+namespace xfile
+{
+	// テキスト形式では1や0のように書かれたFLOATのメンバーもあるので，
+	// リテラルの見た目ではなく，テンプレートのメンバーの型から次に読む値の種類を決める
+	// 配列の要素数はそれより前の整数のメンバーで決まるので，読んだ値を覚えながら進む
+	class XFileTextLayout
+	{
+	public:
+		enum class Slot
+		{
+			// テンプレートが分からないか，メンバーを読み終えた．子のオブジェクトや参照が続く
+			Unknown,
+			Integer,
+			Float,
+			String,
+		};
+
+		// p_templateがnullptrであれば，常にUnknownを返す
+		// メンバーに使われているテンプレートはfile_templates，標準テンプレートの順に探す
+		void reset(const XFileTemplate * p_template, const XFileTemplateRegistry * p_file_templates);
+
+		Slot next();
+
+		// nextで得た種類の値を1つ読んだ．違う種類を読んだ場合は，それ以降はUnknownを返す
+		void consume(Slot slot, uint32_t integer_value = 0);
+
+	private:
+		struct Frame
+		{
+			const XFileTemplate * pTemplate;
+			size_t member;
+
+			// 読んでいるメンバーの残りの要素数．0であればまだメンバーに入っていない
+			uint64_t remaining;
+
+			// 整数のメンバーの値．配列の要素数に使う
+			std::vector<uint32_t> values;
+		};
+
+		const XFileTemplate * findTemplate(const std::string & name) const;
+		bool enterMember(Frame & frame);
+		void pushFrame(const XFileTemplate * p_template);
+		void finishElement();
+
+	private:
+		const XFileTemplateRegistry * mpFileTemplates = nullptr;
+
+		// 入れ子のテンプレートの要素ごとに積む．使い終わったFrameは確保したまま再利用する
+		std::vector<Frame> mFrames;
+		size_t mDepth = 0;
+		bool mBroken = false;
+	};
+}
+
+#endif // XFILE_XFILE_TEXT_LAYOUT_H_INCLUDED
@@ -14,7 +14,7 @@ namespace xfile
 			return false;
 		}
 
-		filename = object.dataArray[0].stringList[0];
+		filename = object.dataArray[0].stringList()[0];
 
 		return true;
 	}
@@ -0,0 +1,81 @@
+#include "XFileThreadPool.h"
+#include <algorithm>
+
+namespace xfile
+{
+	XFileThreadPool::XFileThreadPool(size_t thread_count)
+	{
+		thread_count = std::max<size_t>(thread_count, 1);
+
+		mThreads.reserve(thread_count);
+		for(size_t i = 0; i < thread_count; ++i)
+		{
+			mThreads.emplace_back(&XFileThreadPool::run, this);
+		}
+	}
+
+	XFileThreadPool::~XFileThreadPool()
+	{
+		{
+			std::lock_guard lock(mMutex);
+			mStopping = true;
+		}
+		mCondition.notify_all();
+
+		for(auto & thread : mThreads)
+		{
+			thread.join();
+		}
+	}
+
+	void XFileThreadPool::enqueue(std::function<void()> task)
+	{
+		{
+			std::lock_guard lock(mMutex);
+			mTasks.emplace_back(std::move(task));
+		}
+		mCondition.notify_one();
+	}
+
+	bool XFileThreadPool::runPendingTask()
+	{
+		std::function<void()> task;
+		{
+			std::lock_guard lock(mMutex);
+			if(mTasks.empty())
+			{
+				return false;
+			}
+
+			task = std::move(mTasks.front());
+			mTasks.pop_front();
+		}
+
+		task();
+
+		return true;
+	}
+
+	void XFileThreadPool::run()
+	{
+		while(true)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock lock(mMutex);
+				mCondition.wait(lock, [this] { return mStopping || !mTasks.empty(); });
+
+				// 破棄されるときは積まれているタスクを処理し終えてから抜ける
+				if(mTasks.empty())
+				{
+					return;
+				}
+
+				task = std::move(mTasks.front());
+				mTasks.pop_front();
+			}
+
+			task();
+		}
+	}
+}
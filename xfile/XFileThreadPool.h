@@ -0,0 +1,133 @@
+#pragma once
+#ifndef XFILE_XFILE_THREAD_POOL_H_INCLUDED
+#define XFILE_XFILE_THREAD_POOL_H_INCLUDED
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace xfile
+{
+	class XFileThreadPool
+	{
+	public:
+		XFileThreadPool(size_t thread_count = std::thread::hardware_concurrency());
+
+		XFileThreadPool(const XFileThreadPool &) = delete;
+		XFileThreadPool & operator=(const XFileThreadPool &) = delete;
+
+		~XFileThreadPool();
+
+		size_t threadCount() const noexcept { return mThreads.size(); }
+
+		template <class F>
+		auto submit(F && f) -> std::future<std::invoke_result_t<F>>
+		{
+			using Result = std::invoke_result_t<F>;
+
+			// std::functionはコピーできる必要があるのでshared_ptrで包む
+			auto p_task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(f));
+			auto future = p_task->get_future();
+			enqueue([p_task] { (*p_task)(); });
+
+			return future;
+		}
+
+		// futureの準備ができるまで，積まれているタスクを呼び出したスレッドで処理してから結果を返す
+		// ワーカースレッドが自分のタスクの終わりを待っても，そのタスクが積まれたまま進まなくなることがない
+		template <class T>
+		T get(std::future<T> & future)
+		{
+			while(future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				// 積まれたタスクが無ければ，待っているタスクはどこかのスレッドで処理中になっている
+				if(!runPendingTask())
+				{
+					future.wait();
+					break;
+				}
+			}
+
+			return future.get();
+		}
+
+	private:
+		void enqueue(std::function<void()> task);
+		bool runPendingTask();
+		void run();
+
+	private:
+		std::mutex mMutex;
+		std::condition_variable mCondition;
+		std::deque<std::function<void()>> mTasks;
+		bool mStopping = false;
+
+		std::vector<std::thread> mThreads;
+	};
+
+	// [0, count)をchunk_sizeずつに区切ってf(begin, end)を呼ぶ
+	// 先頭の区切りは呼び出したスレッドで処理する．p_thread_poolがnullptrであればすべて呼び出したスレッドで処理する
+	// 残りを待つ間も積まれたタスクを処理するので，プールのワーカースレッドから呼んでもよい
+	// fが例外を投げても，すべての区切りが終わってから最初の例外を投げ直す
+	template <class F>
+	void parallelFor(XFileThreadPool * p_thread_pool, size_t count, size_t chunk_size, F && f)
+	{
+		if(p_thread_pool == nullptr || count <= chunk_size)
+		{
+			f(size_t(0), count);
+			return;
+		}
+
+		// 積んだ後でfutureを失わないように，先に確保しておく
+		std::vector<std::future<void>> futures;
+		futures.reserve((count - 1) / chunk_size);
+
+		std::exception_ptr p_exception;
+		try
+		{
+			for(size_t begin = chunk_size; begin < count; begin += chunk_size)
+			{
+				size_t end = std::min(begin + chunk_size, count);
+				futures.emplace_back(p_thread_pool->submit([&f, begin, end] { f(begin, end); }));
+			}
+
+			f(size_t(0), chunk_size);
+		}
+		catch(...)
+		{
+			p_exception = std::current_exception();
+		}
+
+		// 積んだタスクはfと，fが参照する呼び出し元の変数を使うので，途中で抜けずに全部待つ
+		for(auto & future : futures)
+		{
+			try
+			{
+				p_thread_pool->get(future);
+			}
+			catch(...)
+			{
+				if(!p_exception)
+				{
+					p_exception = std::current_exception();
+				}
+			}
+		}
+
+		if(p_exception)
+		{
+			std::rethrow_exception(p_exception);
+		}
+	}
+}
+
+#endif // XFILE_XFILE_THREAD_POOL_H_INCLUDED
@@ -0,0 +1,45 @@
+#pragma once
+#ifndef XFILE_XFILE_TOKEN_TYPE_H_INCLUDED
+#define XFILE_XFILE_TOKEN_TYPE_H_INCLUDED
+
+namespace xfile
+{
+	enum class TokenType
+	{
+		Error = -1,
+		None = 0,
+		Name = 1,
+		String = 2,
+		Integer = 3,
+		GUID = 5,
+		IntegerList = 6,
+		FloatList = 7,
+		OpenBrace = 10,
+		CloseBrace = 11,
+		OpenParen = 12,
+		CloseParen = 13,
+		OpenBracket = 14,
+		CloseBracket = 15,
+		OpenAngle = 16,
+		CloseAngle = 17,
+		Dot = 18,
+		Comma = 19,
+		SemiColon = 20,
+		Template = 31,
+		Word = 40,
+		DoubleWord = 41,
+		Float = 42,
+		Double = 43,
+		Char = 44,
+		UnsignedChar = 45,
+		SignedWord = 46,
+		SignedDoubleWord = 47,
+		Void = 48,
+		StringPointer = 49,
+		Unicode = 50,
+		CString = 51,
+		Array = 52
+	};
+}
+
+#endif // XFILE_XFILE_TOKEN_TYPE_H_INCLUDED
@@ -0,0 +1,276 @@
+#include "XFileVertexCache.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+#include "XFileVertexCorners.h"
+
+namespace
+{
+	// Forsythの方法の定数．キャッシュはLRUとして扱う
+	constexpr size_t OptimizerCacheSize = 32;
+	constexpr float CacheDecayPower = 1.5f;
+	constexpr float LastTriangleScore = 0.75f;
+	constexpr float ValenceBoostScale = 2.0f;
+	constexpr float ValenceBoostPower = 0.5f;
+
+	// これより少ない残りの三角形の数は表から引く
+	constexpr size_t ValenceTableSize = 64;
+
+	struct ScoreTable
+	{
+		std::array<float, OptimizerCacheSize> cache;
+		std::array<float, ValenceTableSize> valence;
+	};
+
+	const ScoreTable & scoreTable()
+	{
+		static const ScoreTable table = []
+		{
+			ScoreTable t{};
+			for(size_t i = 0; i < OptimizerCacheSize; ++i)
+			{
+				// 直前の三角形の頂点は，どれを先に使っても同じなので一律にする
+				t.cache[i] = i < 3
+					? LastTriangleScore
+					: std::pow(1.0f - static_cast<float>(i - 3) / (OptimizerCacheSize - 3), CacheDecayPower);
+			}
+
+			t.valence[0] = 0.0f;
+			for(size_t i = 1; i < ValenceTableSize; ++i)
+			{
+				t.valence[i] = ValenceBoostScale * std::pow(static_cast<float>(i), -ValenceBoostPower);
+			}
+
+			return t;
+		}();
+
+		return table;
+	}
+
+	// 残りの三角形が少ない頂点ほど高くして，孤立した三角形が最後まで残らないようにする
+	float vertexScore(int cache_position, uint32_t remaining) noexcept
+	{
+		if(remaining == 0)
+		{
+			return -1.0f;
+		}
+
+		auto & table = scoreTable();
+		float score = cache_position < 0 ? 0.0f : table.cache[cache_position];
+		score += remaining < ValenceTableSize
+			? table.valence[remaining]
+			: ValenceBoostScale * std::pow(static_cast<float>(remaining), -ValenceBoostPower);
+
+		return score;
+	}
+}
+
+namespace xfile
+{
+	XFileVertexCacheStats simulateVertexCache(
+		std::span<const uint32_t> indices,
+		size_t vertex_count,
+		XFileVertexCacheKind kind,
+		size_t cache_size
+	)
+	{
+		for(auto index : indices)
+		{
+			if(index >= vertex_count)
+			{
+				return {};
+			}
+		}
+
+		XFileVertexCacheStats stats
+		{
+			.triangleCount = indices.size() / 3
+		};
+
+		std::vector<uint8_t> referenced(vertex_count, 0);
+		if(kind == XFileVertexCacheKind::Fifo)
+		{
+			// 何回目のミスで入ったかを覚えておけば，その後のミスの数で追い出されたかが分かる
+			std::vector<size_t> inserted(vertex_count, SIZE_MAX);
+			for(auto index : indices)
+			{
+				stats.vertexCount += referenced[index] == 0;
+				referenced[index] = 1;
+
+				if(inserted[index] == SIZE_MAX || stats.missCount - inserted[index] >= cache_size)
+				{
+					inserted[index] = stats.missCount++;
+				}
+			}
+		}
+		else
+		{
+			std::vector<uint32_t> cache;
+			cache.reserve(cache_size + 1);
+			for(auto index : indices)
+			{
+				stats.vertexCount += referenced[index] == 0;
+				referenced[index] = 1;
+
+				auto it = std::find(cache.begin(), cache.end(), index);
+				if(it != cache.end())
+				{
+					std::rotate(cache.begin(), it, it + 1);
+					continue;
+				}
+
+				++stats.missCount;
+				cache.insert(cache.begin(), index);
+				if(cache.size() > cache_size)
+				{
+					cache.pop_back();
+				}
+			}
+		}
+
+		return stats;
+	}
+
+	bool optimizeVertexCache(std::span<uint32_t> indices, size_t vertex_count)
+	{
+		if(indices.size() % 3 != 0)
+		{
+			return false;
+		}
+
+		// 頂点ごとの，まだ並べていない三角形の一覧．並べた三角形は末尾と入れ替えて外す
+		XFileVertexCorners vertex_corners;
+		if(!vertex_corners.setup(indices, vertex_count))
+		{
+			return false;
+		}
+
+		const size_t triangle_count = indices.size() / 3;
+		if(triangle_count <= 1)
+		{
+			return true;
+		}
+
+		std::vector<uint32_t> vertex_triangles(vertex_corners.cornerList.size());
+		std::transform(
+			vertex_corners.cornerList.begin(),
+			vertex_corners.cornerList.end(),
+			vertex_triangles.begin(),
+			[](uint32_t corner) { return corner / 3; }
+		);
+
+		const auto & offsets = vertex_corners.offsets;
+		std::vector<uint32_t> remaining(vertex_count);
+		std::vector<int> cache_positions(vertex_count, -1);
+		std::vector<float> vertex_scores(vertex_count);
+		for(size_t v = 0; v < vertex_count; ++v)
+		{
+			remaining[v] = offsets[v + 1] - offsets[v];
+			vertex_scores[v] = vertexScore(-1, remaining[v]);
+		}
+
+		auto triangleScore = [&](size_t triangle)
+		{
+			return vertex_scores[indices[triangle * 3]] + vertex_scores[indices[triangle * 3 + 1]] + vertex_scores[indices[triangle * 3 + 2]];
+		};
+
+		size_t best_triangle = 0;
+		float best_score = -1.0f;
+		for(size_t t = 0; t < triangle_count; ++t)
+		{
+			float score = triangleScore(t);
+			if(score > best_score)
+			{
+				best_triangle = t;
+				best_score = score;
+			}
+		}
+
+		std::vector<uint8_t> emitted(triangle_count, 0);
+		std::vector<uint32_t> sorted(indices.size());
+		std::array<uint32_t, OptimizerCacheSize + 3> cache;
+		std::array<uint32_t, OptimizerCacheSize + 3> next_cache;
+		size_t cache_count = 0;
+		size_t scan_cursor = 0;
+
+		for(size_t output = 0; output < triangle_count; ++output)
+		{
+			// キャッシュの頂点を使う三角形が無くなったら，まだ並べていない三角形を先頭から探す
+			if(best_score < 0.0f)
+			{
+				while(emitted[scan_cursor])
+				{
+					++scan_cursor;
+				}
+				best_triangle = scan_cursor;
+			}
+
+			emitted[best_triangle] = 1;
+			const uint32_t * p_triangle = &indices[best_triangle * 3];
+			std::copy(p_triangle, p_triangle + 3, &sorted[output * 3]);
+
+			for(size_t k = 0; k < 3; ++k)
+			{
+				auto v = p_triangle[k];
+				auto p_begin = &vertex_triangles[offsets[v]];
+				auto p_end = p_begin + remaining[v];
+				auto p_found = std::find(p_begin, p_end, static_cast<uint32_t>(best_triangle));
+				if(p_found != p_end)
+				{
+					std::swap(*p_found, *(p_end - 1));
+					--remaining[v];
+				}
+			}
+
+			// 並べた三角形の頂点を先頭に置き，残りの頂点を後ろへずらす
+			size_t next_count = 0;
+			for(size_t k = 0; k < 3; ++k)
+			{
+				if(std::find(next_cache.begin(), next_cache.begin() + next_count, p_triangle[k]) == next_cache.begin() + next_count)
+				{
+					next_cache[next_count++] = p_triangle[k];
+				}
+			}
+
+			for(size_t i = 0; i < cache_count; ++i)
+			{
+				auto v = cache[i];
+				if(v != p_triangle[0] && v != p_triangle[1] && v != p_triangle[2])
+				{
+					next_cache[next_count++] = v;
+				}
+			}
+
+			for(size_t i = 0; i < next_count; ++i)
+			{
+				auto v = next_cache[i];
+				cache_positions[v] = i < OptimizerCacheSize ? static_cast<int>(i) : -1;
+				vertex_scores[v] = vertexScore(cache_positions[v], remaining[v]);
+			}
+
+			// 点数が変わるのはキャッシュの頂点を使う三角形だけなので，その中から次を選ぶ
+			best_score = -1.0f;
+			cache_count = std::min(next_count, OptimizerCacheSize);
+			for(size_t i = 0; i < cache_count; ++i)
+			{
+				auto v = next_cache[i];
+				cache[i] = v;
+				for(size_t j = offsets[v]; j < offsets[v] + remaining[v]; ++j)
+				{
+					auto t = vertex_triangles[j];
+					float score = triangleScore(t);
+					if(score > best_score)
+					{
+						best_triangle = t;
+						best_score = score;
+					}
+				}
+			}
+		}
+
+		std::copy(sorted.begin(), sorted.end(), indices.begin());
+
+		return true;
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+#ifndef XFILE_XFILE_VERTEX_CACHE_H_INCLUDED
+#define XFILE_XFILE_VERTEX_CACHE_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace xfile
+{
+	enum class XFileVertexCacheKind
+	{
+		// 古いものから順に追い出す．多くのGPUの頂点キャッシュに近い
+		Fifo,
+		// 最後に使ったのが古いものから追い出す
+		Lru,
+	};
+
+	struct XFileVertexCacheStats
+	{
+		size_t triangleCount = 0;
+		// インデックスから参照されている頂点の数
+		size_t vertexCount = 0;
+		size_t missCount = 0;
+
+		// 三角形あたりの頂点シェーダの実行回数．理想は0.5前後で，最悪は3
+		double acmr() const noexcept { return triangleCount == 0 ? 0.0 : static_cast<double>(missCount) / triangleCount; }
+
+		// 頂点あたりの実行回数．理想は1
+		double atvr() const noexcept { return vertexCount == 0 ? 0.0 : static_cast<double>(missCount) / vertexCount; }
+	};
+
+	// indicesを先頭から順に描いたときの頂点キャッシュのミスを数える
+	// vertex_count以上の番号があれば何も数えない
+	XFileVertexCacheStats simulateVertexCache(
+		std::span<const uint32_t> indices,
+		size_t vertex_count,
+		XFileVertexCacheKind kind,
+		size_t cache_size
+	);
+
+	// Forsythの方法で，頂点キャッシュに残っている頂点を使う三角形が続くように三角形を並べ替える
+	// 三角形の中の頂点の順番は変えないので，面の向きは変わらない
+	bool optimizeVertexCache(std::span<uint32_t> indices, size_t vertex_count);
+}
+
+#endif // XFILE_XFILE_VERTEX_CACHE_H_INCLUDED
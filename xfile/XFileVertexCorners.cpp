@@ -0,0 +1,41 @@
+#include "XFileVertexCorners.h"
+
+namespace xfile
+{
+	bool XFileVertexCorners::setup(std::span<const uint32_t> face_indices, size_t vertex_count)
+	{
+		offsets.assign(vertex_count + 1, 0);
+		cornerList.clear();
+
+		if(face_indices.size() > UINT32_MAX)
+		{
+			return false;
+		}
+
+		// 頂点ごとの角の数を数えてから，それぞれの範囲へ振り分ける
+		for(auto index : face_indices)
+		{
+			if(index >= vertex_count)
+			{
+				offsets.clear();
+				return false;
+			}
+			++offsets[index + 1];
+		}
+
+		for(size_t v = 0; v < vertex_count; ++v)
+		{
+			offsets[v + 1] += offsets[v];
+		}
+
+		cornerList.resize(face_indices.size());
+
+		std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+		for(uint32_t corner = 0; corner < face_indices.size(); ++corner)
+		{
+			cornerList[cursors[face_indices[corner]]++] = corner;
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+#ifndef XFILE_XFILE_VERTEX_CORNERS_H_INCLUDED
+#define XFILE_XFILE_VERTEX_CORNERS_H_INCLUDED
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace xfile
+{
+	// 頂点ごとに，その頂点を使う三角形の角をまとめた表．角はfaceIndicesでの位置で表す
+	// 同じ頂点の角は位置の小さい順に並ぶので，足し合わせる順番が常に同じになる
+	struct XFileVertexCorners
+	{
+		// face_indicesにvertex_count以上の番号があればfalse
+		bool setup(std::span<const uint32_t> face_indices, size_t vertex_count);
+
+		size_t vertexCount() const noexcept { return offsets.empty() ? 0 : offsets.size() - 1; }
+
+		std::span<const uint32_t> corners(size_t vertex) const noexcept
+		{
+			return { cornerList.data() + offsets[vertex], cornerList.data() + offsets[vertex + 1] };
+		}
+
+		// 頂点ごとの最初の角のcornerListでの位置．最後に角の数を置く
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> cornerList;
+	};
+}
+
+#endif // XFILE_XFILE_VERTEX_CORNERS_H_INCLUDED
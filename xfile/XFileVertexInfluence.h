@@ -0,0 +1,20 @@
+#pragma once
+#ifndef XFILE_XFILE_VERTEX_INFLUENCE_H_INCLUDED
+#define XFILE_XFILE_VERTEX_INFLUENCE_H_INCLUDED
+
+#include <cstdint>
+
+namespace xfile
+{
+	// 頂点ごとに影響の大きいボーンを最大4本まで持つ
+	// boneIndicesはXFileMesh::skinWeightsの番号で，使わない枠は重みを0にする
+	struct XFileVertexInfluence
+	{
+		static constexpr uint32_t MaxBones = 4;
+
+		uint16_t boneIndices[MaxBones] = {};
+		float weights[MaxBones] = {};
+	};
+}
+
+#endif // XFILE_XFILE_VERTEX_INFLUENCE_H_INCLUDED
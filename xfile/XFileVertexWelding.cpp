@@ -0,0 +1,179 @@
+#include "XFileVertexWelding.h"
+#include <algorithm>
+#include <bit>
+#include "XFileMesh.h"
+
+namespace
+{
+	constexpr uint32_t EmptySlot = UINT32_MAX;
+
+	// ハッシュの下位ビットで位置を決め，埋まっていれば次の位置を見る
+	// ハッシュも入れておき，組を比べる前にハッシュで違う組を弾く
+	struct Slot
+	{
+		uint32_t hash;
+		uint32_t vertex;
+	};
+
+	// 列ごとに全ての角をまとめて混ぜるので，ループがベクトル化しやすい
+	void hashStreams(std::span<const std::span<const uint32_t>> streams, std::vector<uint32_t> & hashes)
+	{
+		hashes.assign(streams[0].size(), 0x811C9DC5u);
+		auto p_hashes = hashes.data();
+		const auto count = hashes.size();
+		for(auto stream : streams)
+		{
+			auto p_stream = stream.data();
+			for(size_t i = 0; i < count; ++i)
+			{
+				p_hashes[i] = (p_hashes[i] ^ p_stream[i]) * 0x9E3779B1u;
+			}
+		}
+
+		for(size_t i = 0; i < count; ++i)
+		{
+			auto h = p_hashes[i];
+			h ^= h >> 16;
+			h *= 0x85EBCA6Bu;
+			h ^= h >> 13;
+			p_hashes[i] = h;
+		}
+	}
+}
+
+namespace xfile
+{
+	bool XFileVertexWelding::setup(std::span<const std::span<const uint32_t>> streams)
+	{
+		streamCount = 0;
+		hasNormals = false;
+		vertexIndices.clear();
+		corners.clear();
+		indices.clear();
+
+		if(streams.empty())
+		{
+			return false;
+		}
+
+		const auto corner_count = streams[0].size();
+		if(corner_count >= UINT32_MAX)
+		{
+			return false;
+		}
+
+		for(auto stream : streams)
+		{
+			if(stream.size() != corner_count)
+			{
+				return false;
+			}
+		}
+
+		streamCount = streams.size();
+		if(corner_count == 0)
+		{
+			return true;
+		}
+
+		std::vector<uint32_t> hashes;
+		hashStreams(streams, hashes);
+
+		// 頂点は角より多くならないので，角の数から埋まるのが3/4以下になる大きさにする
+		const size_t capacity = std::bit_ceil(std::max<size_t>(corner_count + corner_count / 3 + 1, 16));
+		const size_t mask = capacity - 1;
+		std::vector<Slot> slots(capacity, Slot{ 0, EmptySlot });
+
+		indices.resize(corner_count);
+		for(size_t corner = 0; corner < corner_count; ++corner)
+		{
+			const auto hash = hashes[corner];
+			for(size_t i = hash & mask; ; i = (i + 1) & mask)
+			{
+				auto & slot = slots[i];
+				if(slot.vertex == EmptySlot)
+				{
+					slot = { hash, static_cast<uint32_t>(vertexCount()) };
+					for(auto stream : streams)
+					{
+						vertexIndices.push_back(stream[corner]);
+					}
+					corners.push_back(static_cast<uint32_t>(corner));
+					indices[corner] = slot.vertex;
+					break;
+				}
+
+				if(slot.hash != hash)
+				{
+					continue;
+				}
+
+				auto p_source = &vertexIndices[slot.vertex * streamCount];
+				bool same = true;
+				for(size_t s = 0; s < streamCount && same; ++s)
+				{
+					same = p_source[s] == streams[s][corner];
+				}
+
+				if(same)
+				{
+					indices[corner] = slot.vertex;
+					break;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	bool XFileVertexWelding::setup(const XFileMesh & mesh, std::span<const uint32_t> extra_keys)
+	{
+		bool pending_normals = std::any_of(mesh.lazyObjects.begin(), mesh.lazyObjects.end(), [](const XFileLazyObject & lazy_object)
+		{
+			return lazy_object.name == "MeshNormals";
+		});
+
+		bool valid = !pending_normals && (extra_keys.empty() || extra_keys.size() == mesh.faceIndices.size());
+		for(size_t i = 0; i < mesh.faceIndices.size() && valid; ++i)
+		{
+			valid = mesh.faceIndices[i] < mesh.vertices.size();
+		}
+
+		if(!valid)
+		{
+			streamCount = 0;
+			hasNormals = false;
+			vertexIndices.clear();
+			corners.clear();
+			indices.clear();
+			return false;
+		}
+
+		const auto & normals = mesh.normals;
+		bool has_normals = !normals.normals.empty() && normals.faceNormalIndices.size() == mesh.faceIndices.size();
+		for(size_t i = 0; i < normals.faceNormalIndices.size() && has_normals; ++i)
+		{
+			has_normals = normals.faceNormalIndices[i] < normals.normals.size();
+		}
+
+		std::span<const uint32_t> streams[3] = { mesh.faceIndices };
+		size_t stream_count = 1;
+		if(has_normals)
+		{
+			streams[stream_count++] = normals.faceNormalIndices;
+		}
+		if(!extra_keys.empty())
+		{
+			streams[stream_count++] = extra_keys;
+		}
+
+		if(!setup(std::span(streams, stream_count)))
+		{
+			return false;
+		}
+
+		hasNormals = has_normals;
+
+		return true;
+	}
+}
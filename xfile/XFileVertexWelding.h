@@ -0,0 +1,54 @@
+#pragma once
+#ifndef XFILE_XFILE_VERTEX_WELDING_H_INCLUDED
+#define XFILE_XFILE_VERTEX_WELDING_H_INCLUDED
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace xfile
+{
+	struct XFileMesh;
+
+	// 角ごとの番号の組(位置の番号，法線の番号など)が同じ角を1つの頂点にまとめ，
+	// 1つのインデックスバッファで引ける頂点の並びを作る
+	// 頂点は組が最初に現れた順に並ぶので，同じ入力からは常に同じ結果になる
+	struct XFileVertexWelding
+	{
+		// setup(const XFileMesh &)での番号の列の並び
+		static constexpr size_t PositionStream = 0;
+		static constexpr size_t NormalStream = 1;
+
+		// streamsは角ごとの番号の列．すべて同じ長さにする
+		bool setup(std::span<const std::span<const uint32_t>> streams);
+
+		// mesh.faceIndicesと，使えればmesh.normals.faceNormalIndicesの組でまとめる
+		// テクスチャ座標は位置と同じ番号で引くので，組には含めない
+		// extra_keysを渡すと角ごとのその値も組に加え，最後の列に置く
+		// 接線の向き(wの符号)を渡せば，テクスチャを反転させた継ぎ目の角がまとめられなくなる
+		// 遅延読み込みしたメッシュはfindNormalsを先に呼んでおく．法線が読み飛ばされたままであればfalse
+		bool setup(const XFileMesh & mesh, std::span<const uint32_t> extra_keys = {});
+
+		size_t vertexCount() const noexcept { return streamCount == 0 ? 0 : vertexIndices.size() / streamCount; }
+
+		// まとめた頂点vertexのstream番目の列での番号
+		uint32_t sourceIndex(size_t vertex, size_t stream) const noexcept { return vertexIndices[vertex * streamCount + stream]; }
+
+		size_t streamCount = 0;
+
+		// setup(const XFileMesh &)で法線の列を組に含めたか
+		bool hasNormals = false;
+
+		// まとめた頂点ごとに，元の番号をstreamCount個ずつ並べたもの
+		std::vector<uint32_t> vertexIndices;
+
+		// まとめた頂点ごとに，その頂点に最初にまとめた角の番号
+		// 接線のように角ごとに作った値は，これで頂点の値を引ける
+		std::vector<uint32_t> corners;
+
+		// 角ごとのまとめた頂点の番号．そのままインデックスバッファにできる
+		std::vector<uint32_t> indices;
+	};
+}
+
+#endif // XFILE_XFILE_VERTEX_WELDING_H_INCLUDED
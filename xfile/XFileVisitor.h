@@ -0,0 +1,36 @@
+#pragma once
+#ifndef XFILE_XFILE_VISITOR_H_INCLUDED
+#define XFILE_XFILE_VISITOR_H_INCLUDED
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include "XFileLazyObject.h"
+
+namespace xfile
+{
+	// XFileReaderが読み込んだ順にデータを通知する
+	// 渡されるビューは，それを含むトップレベルのオブジェクトのendObjectから戻るまで有効
+	// falseを返すと読み込みを中断する
+	class XFileVisitor
+	{
+	public:
+		virtual ~XFileVisitor() = default;
+
+		virtual bool beginObject(std::string_view name, std::string_view optional_name) = 0;
+		virtual bool endObject() = 0;
+
+		virtual bool integerList(std::span<const uint32_t>) { return true; }
+		virtual bool floatList(std::span<const float>) { return true; }
+		virtual bool doubleList(std::span<const double>) { return true; }
+		virtual bool string(std::string_view) { return true; }
+
+		// { name }の形で別のオブジェクトを名前で参照している
+		virtual bool reference(std::string_view) { return true; }
+
+		// 遅延読み込みで子オブジェクトを読み飛ばした．beginObjectとendObjectの代わりに呼ばれる
+		virtual bool lazyObject(const XFileLazyRange &) { return true; }
+	};
+}
+
+#endif // XFILE_XFILE_VISITOR_H_INCLUDED
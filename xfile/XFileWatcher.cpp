@@ -0,0 +1,281 @@
+#include "XFileWatcher.h"
+#include <algorithm>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	// 止めるように頼まれたかを確かめる間隔
+	constexpr int PollIntervalMilliseconds = 100;
+}
+
+namespace xfile
+{
+	XFileWatcher::XFileWatcher(const char * p_directory_path)
+	{
+		open(p_directory_path);
+	}
+
+	XFileWatcher::~XFileWatcher()
+	{
+		close();
+	}
+
+	bool XFileWatcher::takeChanges(std::vector<std::string> & file_names)
+	{
+		std::lock_guard lock(mMutex);
+		if(mChanges.empty() || std::chrono::steady_clock::now() - mLastChangeTime < SettleTime)
+		{
+			return false;
+		}
+
+		file_names = std::move(mChanges);
+		mChanges.clear();
+
+		return true;
+	}
+
+	void XFileWatcher::addChange(std::string file_name)
+	{
+		std::lock_guard lock(mMutex);
+		if(std::find(mChanges.begin(), mChanges.end(), file_name) == mChanges.end())
+		{
+			mChanges.emplace_back(std::move(file_name));
+		}
+		mLastChangeTime = std::chrono::steady_clock::now();
+	}
+
+#if defined(_WIN32)
+	bool XFileWatcher::open(const char * p_directory_path)
+	{
+		if(isOpen())
+		{
+			return false;
+		}
+
+		HANDLE h_directory = CreateFileA(
+			p_directory_path,
+			FILE_LIST_DIRECTORY,
+			FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			nullptr,
+			OPEN_EXISTING,
+			FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+			nullptr
+		);
+		if(h_directory == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		mhDirectory = h_directory;
+
+		mThread = std::jthread([this](std::stop_token stop_token)
+		{
+			watch(stop_token);
+		});
+
+		return true;
+	}
+
+	bool XFileWatcher::close()
+	{
+		if(mThread.joinable())
+		{
+			mThread.request_stop();
+			mThread.join();
+		}
+		mFailed = false;
+
+		if(mhDirectory != nullptr)
+		{
+			CloseHandle(mhDirectory);
+			mhDirectory = nullptr;
+		}
+
+		return true;
+	}
+
+	void XFileWatcher::watch(std::stop_token stop_token)
+	{
+		HANDLE h_event = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+		if(h_event == nullptr)
+		{
+			mFailed = true;
+			return;
+		}
+
+		// FILE_NOTIFY_INFORMATIONはDWORD境界に置く必要がある
+		alignas(DWORD) std::byte buffer[16 * 1024];
+
+		while(!stop_token.stop_requested())
+		{
+			OVERLAPPED overlapped{};
+			overlapped.hEvent = h_event;
+			ResetEvent(h_event);
+
+			BOOL succeeded = ReadDirectoryChangesW(
+				mhDirectory,
+				buffer,
+				sizeof(buffer),
+				FALSE,
+				FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE,
+				nullptr,
+				&overlapped,
+				nullptr
+			);
+			if(!succeeded)
+			{
+				break;
+			}
+
+			DWORD wait_result = WAIT_TIMEOUT;
+			while(wait_result == WAIT_TIMEOUT && !stop_token.stop_requested())
+			{
+				wait_result = WaitForSingleObject(h_event, PollIntervalMilliseconds);
+			}
+
+			DWORD size = 0;
+			if(wait_result != WAIT_OBJECT_0)
+			{
+				// 待っている読み込みを取り消し，バッファを手放す前に終わるのを待つ
+				CancelIoEx(mhDirectory, &overlapped);
+				GetOverlappedResult(mhDirectory, &overlapped, &size, TRUE);
+				break;
+			}
+
+			if(!GetOverlappedResult(mhDirectory, &overlapped, &size, FALSE))
+			{
+				break;
+			}
+
+			// バッファが溢れた場合はsizeが0になり，何が変わったかは分からない
+			for(size_t offset = 0; size != 0;)
+			{
+				auto p_info = reinterpret_cast<const FILE_NOTIFY_INFORMATION *>(buffer + offset);
+				if(p_info->Action == FILE_ACTION_ADDED || p_info->Action == FILE_ACTION_MODIFIED || p_info->Action == FILE_ACTION_RENAMED_NEW_NAME)
+				{
+					int name_length = static_cast<int>(p_info->FileNameLength / sizeof(WCHAR));
+					int length = WideCharToMultiByte(CP_ACP, 0, p_info->FileName, name_length, nullptr, 0, nullptr, nullptr);
+					std::string file_name(static_cast<size_t>(length), '\0');
+					WideCharToMultiByte(CP_ACP, 0, p_info->FileName, name_length, file_name.data(), length, nullptr, nullptr);
+					addChange(std::move(file_name));
+				}
+
+				if(p_info->NextEntryOffset == 0)
+				{
+					break;
+				}
+				offset += p_info->NextEntryOffset;
+			}
+		}
+
+		CloseHandle(h_event);
+
+		// 止めるように頼まれる前に抜けたのは，読み込みか待機に失敗したから
+		mFailed = !stop_token.stop_requested();
+	}
+#else
+	bool XFileWatcher::open(const char * p_directory_path)
+	{
+		if(isOpen())
+		{
+			return false;
+		}
+
+		mNotifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if(mNotifyDescriptor < 0)
+		{
+			return false;
+		}
+
+		// 置き換えて保存するエディタもあるので，書き込みの完了と移動の両方を見る
+		if(inotify_add_watch(mNotifyDescriptor, p_directory_path, IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+		{
+			close();
+			return false;
+		}
+
+		mThread = std::jthread([this](std::stop_token stop_token)
+		{
+			watch(stop_token);
+		});
+
+		return true;
+	}
+
+	bool XFileWatcher::close()
+	{
+		if(mThread.joinable())
+		{
+			mThread.request_stop();
+			mThread.join();
+		}
+		mFailed = false;
+
+		if(mNotifyDescriptor >= 0)
+		{
+			::close(mNotifyDescriptor);
+			mNotifyDescriptor = -1;
+		}
+
+		return true;
+	}
+
+	void XFileWatcher::watch(std::stop_token stop_token)
+	{
+		alignas(inotify_event) std::byte buffer[16 * 1024];
+
+		while(!stop_token.stop_requested())
+		{
+			pollfd poll_fd
+			{
+				.fd = mNotifyDescriptor,
+				.events = POLLIN,
+				.revents = 0
+			};
+			int result = poll(&poll_fd, 1, PollIntervalMilliseconds);
+			if(result < 0 && errno != EINTR)
+			{
+				// 記述子が使えなくなった場合は，待たずに同じ失敗を繰り返すだけなので監視をやめる
+				break;
+			}
+			if(result <= 0)
+			{
+				continue;
+			}
+
+			auto size = read(mNotifyDescriptor, buffer, sizeof(buffer));
+			if(size < 0 && errno != EAGAIN && errno != EINTR)
+			{
+				break;
+			}
+			if(size <= 0)
+			{
+				continue;
+			}
+
+			for(ssize_t offset = 0; offset < size;)
+			{
+				auto p_event = reinterpret_cast<const inotify_event *>(buffer + offset);
+				if(p_event->len != 0 && (p_event->mask & IN_ISDIR) == 0)
+				{
+					addChange(p_event->name);
+				}
+
+				offset += static_cast<ssize_t>(sizeof(inotify_event) + p_event->len);
+			}
+		}
+
+		mFailed = !stop_token.stop_requested();
+	}
+#endif
+}
@@ -0,0 +1,65 @@
+#pragma once
+#ifndef XFILE_XFILE_WATCHER_H_INCLUDED
+#define XFILE_XFILE_WATCHER_H_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace xfile
+{
+	// 1つのディレクトリの直下にあるファイルの変更を専用のスレッドで監視する
+	// LinuxではinotifyをWindowsではReadDirectoryChangesWを使う
+	// 監視を続けられないエラーが起きた場合はスレッドを終え，それ以降の変更は知らせない
+	// failedで分かるので，close()してからopen()し直す
+	class XFileWatcher
+	{
+	public:
+		// 保存の途中で読まないように，最後の変更からこれだけ経ってから知らせる
+		static constexpr std::chrono::milliseconds SettleTime{ 100 };
+
+		XFileWatcher() = default;
+		XFileWatcher(const char * p_directory_path);
+
+		XFileWatcher(const XFileWatcher &) = delete;
+		XFileWatcher & operator=(const XFileWatcher &) = delete;
+
+		~XFileWatcher();
+
+		bool open(const char * p_directory_path);
+		bool close();
+
+		bool isOpen() const noexcept { return mThread.joinable(); }
+
+		// エラーで監視が止まっていればtrue．close()するまでtrueのまま
+		bool failed() const noexcept { return mFailed; }
+
+		// 前回から書き込みや置き換えのあったファイルの名前をディレクトリからの相対パスで受け取る
+		// 同じファイルは1つにまとめる．変更が落ち着いていなければfalseを返して何も渡さない
+		bool takeChanges(std::vector<std::string> & file_names);
+
+	private:
+		void watch(std::stop_token stop_token);
+		void addChange(std::string file_name);
+
+	private:
+		std::mutex mMutex;
+		std::vector<std::string> mChanges;
+		std::chrono::steady_clock::time_point mLastChangeTime;
+		std::atomic<bool> mFailed = false;
+
+#if defined(_WIN32)
+		void * mhDirectory = nullptr;
+#else
+		int mNotifyDescriptor = -1;
+#endif
+
+		// スレッドはほかのメンバーを参照するので，最初に破棄されるよう最後に置く
+		std::jthread mThread;
+	};
+}
+
+#endif // XFILE_XFILE_WATCHER_H_INCLUDED
@@ -0,0 +1,390 @@
+#include "XFileWriter.h"
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	constexpr char XFileHeader[] = "xof 0303bin 0032";
+}
+
+namespace xfile
+{
+	bool XFileWriter::write(const XFile & xfile, std::vector<std::byte> & bytes)
+	{
+		bytes.clear();
+
+		// 読み飛ばした法線などを黙って落とさないように，書き出す前に断る
+		if(xfile.hasLazyObjects())
+		{
+			return false;
+		}
+
+		mpOutput = &bytes;
+
+		// 頂点などの配列がほとんどを占めるので，先にまとめて確保しておく
+		size_t estimated_size = sizeof(XFileHeader);
+		for(const auto & mesh : xfile.meshes)
+		{
+			estimated_size += sizeof(XFileVector) * (mesh.vertices.size() + mesh.normals.normals.size());
+			estimated_size += sizeof(uint32_t) * 4 * (mesh.faceCount() + mesh.normals.faceNormalIndices.size() / 3);
+			estimated_size += sizeof(XFileCoords2d) * mesh.textureCoords.textureCoords.size();
+			estimated_size += sizeof(uint32_t) * mesh.materialList.faceIndexes.size();
+		}
+		bytes.reserve(estimated_size);
+
+		mChildFrames.assign(xfile.frames.size(), {});
+		mFrameMeshes.assign(xfile.frames.size(), {});
+		for(uint32_t i = 0; i < xfile.frames.size(); ++i)
+		{
+			auto parent = xfile.frames.parents[i];
+			if(parent != XFileFrameTable::NoParent)
+			{
+				if(parent >= i)
+				{
+					return false;
+				}
+				mChildFrames[parent].emplace_back(i);
+			}
+		}
+
+		writeHeader();
+
+		for(uint32_t i = 0; i < xfile.meshes.size(); ++i)
+		{
+			auto frame_index = xfile.meshes[i].frameIndex;
+			if(frame_index == XFileFrameTable::NoParent)
+			{
+				writeMesh(xfile.meshes[i]);
+			}
+			else if(frame_index < xfile.frames.size())
+			{
+				mFrameMeshes[frame_index].emplace_back(i);
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		// 親より前に子が来ることはないので，先頭から根のフレームを書けば番号は変わらない
+		for(uint32_t i = 0; i < xfile.frames.size(); ++i)
+		{
+			if(xfile.frames.parents[i] == XFileFrameTable::NoParent)
+			{
+				writeFrame(xfile, i);
+			}
+		}
+
+		for(const auto & animation_set : xfile.animationSets)
+		{
+			writeAnimationSet(animation_set);
+		}
+
+		mpOutput = nullptr;
+
+		return true;
+	}
+
+	bool XFileWriter::write(const XFile & xfile, const char * p_file_path)
+	{
+		std::vector<std::byte> bytes;
+		if(!write(xfile, bytes))
+		{
+			return false;
+		}
+
+		std::ofstream fout(p_file_path, std::ios::binary);
+		if(!fout)
+		{
+			return false;
+		}
+
+		fout.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+		return static_cast<bool>(fout);
+	}
+
+	void XFileWriter::writeHeader()
+	{
+		auto p_header = reinterpret_cast<const std::byte *>(XFileHeader);
+		mpOutput->insert(mpOutput->end(), p_header, p_header + sizeof(XFileHeader) - 1);
+	}
+
+	void XFileWriter::writeTokenType(TokenType token_type)
+	{
+		auto t = static_cast<int16_t>(token_type);
+		auto p_token = reinterpret_cast<const std::byte *>(&t);
+		mpOutput->insert(mpOutput->end(), p_token, p_token + sizeof(t));
+	}
+
+	void XFileWriter::writeValue(uint32_t value)
+	{
+		auto p_value = reinterpret_cast<const std::byte *>(&value);
+		mpOutput->insert(mpOutput->end(), p_value, p_value + sizeof(value));
+	}
+
+	void XFileWriter::writeName(std::string_view name)
+	{
+		writeTokenType(TokenType::Name);
+		writeValue(static_cast<uint32_t>(name.size()));
+
+		auto p_name = reinterpret_cast<const std::byte *>(name.data());
+		mpOutput->insert(mpOutput->end(), p_name, p_name + name.size());
+	}
+
+	void XFileWriter::writeString(std::string_view s)
+	{
+		writeTokenType(TokenType::String);
+		writeValue(static_cast<uint32_t>(s.size()));
+
+		auto p_string = reinterpret_cast<const std::byte *>(s.data());
+		mpOutput->insert(mpOutput->end(), p_string, p_string + s.size());
+
+		writeTokenType(TokenType::SemiColon);
+	}
+
+	void XFileWriter::writeReference(std::string_view name)
+	{
+		writeTokenType(TokenType::OpenBrace);
+		writeName(name);
+		writeTokenType(TokenType::CloseBrace);
+	}
+
+	void XFileWriter::beginObject(std::string_view name, std::string_view optional_name)
+	{
+		writeName(name);
+		if(!optional_name.empty())
+		{
+			writeName(optional_name);
+		}
+		writeTokenType(TokenType::OpenBrace);
+	}
+
+	void XFileWriter::endObject()
+	{
+		writeTokenType(TokenType::CloseBrace);
+	}
+
+	std::byte * XFileWriter::appendList(TokenType token_type, size_t count, size_t element_size)
+	{
+		writeTokenType(token_type);
+		writeValue(static_cast<uint32_t>(count));
+
+		size_t offset = mpOutput->size();
+		mpOutput->resize(offset + count * element_size);
+
+		return mpOutput->data() + offset;
+	}
+
+	void XFileWriter::writeIntegerList(std::span<const uint32_t> list)
+	{
+		auto p_list = appendList(TokenType::IntegerList, list.size(), sizeof(uint32_t));
+		memcpy(p_list, list.data(), list.size_bytes());
+	}
+
+	void XFileWriter::writeFloatList(std::span<const float> list)
+	{
+		auto p_list = appendList(TokenType::FloatList, list.size(), sizeof(float));
+		memcpy(p_list, list.data(), list.size_bytes());
+	}
+
+	void XFileWriter::writeFaceList(std::span<const uint32_t> indices)
+	{
+		// 面の数と，面ごとの頂点数と頂点番号を1つのリストにする
+		auto face_count = static_cast<uint32_t>(indices.size() / 3);
+		auto p_list = appendList(TokenType::IntegerList, 1 + size_t(4) * face_count, sizeof(uint32_t));
+
+		memcpy(p_list, &face_count, sizeof(face_count));
+		p_list += sizeof(face_count);
+
+		constexpr uint32_t index_count = 3;
+		for(size_t i = 0; i < indices.size(); i += 3)
+		{
+			memcpy(p_list, &index_count, sizeof(index_count));
+			p_list += sizeof(index_count);
+
+			memcpy(p_list, &indices[i], sizeof(uint32_t) * index_count);
+			p_list += sizeof(uint32_t) * index_count;
+		}
+	}
+
+	void XFileWriter::writeFrame(const XFile & xfile, uint32_t frame_index)
+	{
+		beginObject("Frame", xfile.frames.names[frame_index]);
+
+		beginObject("FrameTransformMatrix");
+		writeFloatList({ &xfile.frames.localMatrices[frame_index].m[0][0], 16 });
+		endObject();
+
+		for(auto mesh_index : mFrameMeshes[frame_index])
+		{
+			writeMesh(xfile.meshes[mesh_index]);
+		}
+
+		for(auto child : mChildFrames[frame_index])
+		{
+			writeFrame(xfile, child);
+		}
+
+		endObject();
+	}
+
+	void XFileWriter::writeMesh(const XFileMesh & mesh)
+	{
+		beginObject("Mesh", mesh.name);
+
+		uint32_t vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+		writeIntegerList({ &vertex_count, 1 });
+		writeFloatList({ reinterpret_cast<const float *>(mesh.vertices.data()), mesh.vertices.size() * 3 });
+		writeFaceList(mesh.faceIndices);
+
+		if(!mesh.normals.normals.empty())
+		{
+			beginObject("MeshNormals");
+			uint32_t normal_count = static_cast<uint32_t>(mesh.normals.normals.size());
+			writeIntegerList({ &normal_count, 1 });
+			writeFloatList({ reinterpret_cast<const float *>(mesh.normals.normals.data()), mesh.normals.normals.size() * 3 });
+			writeFaceList(mesh.normals.faceNormalIndices);
+			endObject();
+		}
+
+		if(!mesh.textureCoords.textureCoords.empty())
+		{
+			beginObject("MeshTextureCoords");
+			uint32_t texture_coord_count = static_cast<uint32_t>(mesh.textureCoords.textureCoords.size());
+			writeIntegerList({ &texture_coord_count, 1 });
+			writeFloatList({ reinterpret_cast<const float *>(mesh.textureCoords.textureCoords.data()), mesh.textureCoords.textureCoords.size() * 2 });
+			endObject();
+		}
+
+		if(!mesh.materialList.materials.empty())
+		{
+			const auto & material_list = mesh.materialList;
+			beginObject("MeshMaterialList");
+
+			auto p_list = appendList(TokenType::IntegerList, 2 + material_list.faceIndexes.size(), sizeof(uint32_t));
+			uint32_t counts[] = { static_cast<uint32_t>(material_list.materials.size()), static_cast<uint32_t>(material_list.faceIndexes.size()) };
+			memcpy(p_list, counts, sizeof(counts));
+			memcpy(p_list + sizeof(counts), material_list.faceIndexes.data(), sizeof(uint32_t) * material_list.faceIndexes.size());
+
+			for(const auto & material : material_list.materials)
+			{
+				writeMaterial(material);
+			}
+
+			endObject();
+		}
+
+		if(!mesh.skinWeights.empty())
+		{
+			beginObject("XSkinMeshHeader");
+			uint32_t header[] =
+			{
+				mesh.skinMeshHeader.maxSkinWeightsPerVertex,
+				mesh.skinMeshHeader.maxSkinWeightsPerFace,
+				mesh.skinMeshHeader.bones
+			};
+			writeIntegerList(header);
+			endObject();
+
+			for(const auto & skin_weights : mesh.skinWeights)
+			{
+				writeSkinWeights(skin_weights);
+			}
+		}
+
+		endObject();
+	}
+
+	void XFileWriter::writeMaterial(const XFileMaterial & material)
+	{
+		beginObject("Material");
+
+		float float_list[] =
+		{
+			material.faceColor.red,
+			material.faceColor.green,
+			material.faceColor.blue,
+			material.faceColor.alpha,
+			material.power,
+			material.specularColor.red,
+			material.specularColor.green,
+			material.specularColor.blue,
+			material.emissiveColor.red,
+			material.emissiveColor.green,
+			material.emissiveColor.blue,
+		};
+		writeFloatList(float_list);
+
+		if(!material.textureFilename.filename.empty())
+		{
+			beginObject("TextureFilename");
+			writeString(material.textureFilename.filename);
+			endObject();
+		}
+
+		endObject();
+	}
+
+	void XFileWriter::writeSkinWeights(const XFileSkinWeights & skin_weights)
+	{
+		beginObject("SkinWeights");
+
+		writeString(skin_weights.transformNodeName);
+
+		auto weight_count = skin_weights.vertexIndices.size();
+		auto p_indices = appendList(TokenType::IntegerList, 1 + weight_count, sizeof(uint32_t));
+		auto count = static_cast<uint32_t>(weight_count);
+		memcpy(p_indices, &count, sizeof(count));
+		memcpy(p_indices + sizeof(count), skin_weights.vertexIndices.data(), sizeof(uint32_t) * weight_count);
+
+		auto p_weights = appendList(TokenType::FloatList, weight_count + 16, sizeof(float));
+		memcpy(p_weights, skin_weights.weights.data(), sizeof(float) * weight_count);
+		memcpy(p_weights + sizeof(float) * weight_count, &skin_weights.matrixOffset.m[0][0], sizeof(float) * 16);
+
+		endObject();
+	}
+
+	void XFileWriter::writeAnimationSet(const XFileAnimationSet & animation_set)
+	{
+		beginObject("AnimationSet", animation_set.name);
+
+		// チャンネルごとにAnimationを1つずつ書く
+		for(const auto & channel : animation_set.channels)
+		{
+			beginObject("Animation");
+			if(!channel.frameName.empty())
+			{
+				writeReference(channel.frameName);
+			}
+
+			beginObject("AnimationKey");
+			uint32_t header[] = { static_cast<uint32_t>(channel.keyType), channel.keyCount };
+			writeIntegerList(header);
+
+			for(uint32_t i = 0; i < channel.keyCount; ++i)
+			{
+				uint32_t key[] = { static_cast<uint32_t>(animation_set.times[channel.firstKey + i]), channel.valueCount };
+				writeIntegerList(key);
+
+				const float * p_values = &animation_set.values[channel.firstValue + static_cast<size_t>(i) * channel.valueCount];
+				auto p_list = appendList(TokenType::FloatList, channel.valueCount, sizeof(float));
+				if(channel.keyType == XFileAnimationKeyType::Rotation)
+				{
+					// ファイルでは回転を(w, x, y, z)の順に並べる
+					float rotation[] = { p_values[3], p_values[0], p_values[1], p_values[2] };
+					memcpy(p_list, rotation, sizeof(rotation));
+				}
+				else
+				{
+					memcpy(p_list, p_values, sizeof(float) * channel.valueCount);
+				}
+			}
+
+			endObject();
+			endObject();
+		}
+
+		endObject();
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+#ifndef XFILE_XFILE_WRITER_H_INCLUDED
+#define XFILE_XFILE_WRITER_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "XFile.h"
+#include "XFileTokenType.h"
+
+namespace xfile
+{
+	// XFileをXFileReaderで読めるバイナリ形式(32ビット浮動小数点数)で書き出す
+	// リストは配列から一度にコピーする
+	// 遅延読み込みの子が残っているメッシュは中身を書けないので，XFile::loadLazyObjectsを呼んでから渡す
+	class XFileWriter
+	{
+	public:
+		bool write(const XFile & xfile, std::vector<std::byte> & bytes);
+		bool write(const XFile & xfile, const char * p_file_path);
+
+	private:
+		void writeHeader();
+		void writeTokenType(TokenType token_type);
+		void writeValue(uint32_t value);
+		void writeName(std::string_view name);
+		void writeString(std::string_view s);
+		void writeReference(std::string_view name);
+		void beginObject(std::string_view name, std::string_view optional_name = {});
+		void endObject();
+
+		// トークンと要素数を書き，要素を書き込む場所を返す
+		// 返した場所は次に書き込むまで有効
+		std::byte * appendList(TokenType token_type, size_t count, size_t element_size);
+
+		void writeIntegerList(std::span<const uint32_t> list);
+		void writeFloatList(std::span<const float> list);
+		void writeFaceList(std::span<const uint32_t> indices);
+
+		void writeFrame(const XFile & xfile, uint32_t frame_index);
+		void writeMesh(const XFileMesh & mesh);
+		void writeMaterial(const XFileMaterial & material);
+		void writeSkinWeights(const XFileSkinWeights & skin_weights);
+		void writeAnimationSet(const XFileAnimationSet & animation_set);
+
+	private:
+		std::vector<std::byte> * mpOutput = nullptr;
+
+		// フレームごとの子フレームとメッシュの番号
+		std::vector<std::vector<uint32_t>> mChildFrames;
+		std::vector<std::vector<uint32_t>> mFrameMeshes;
+	};
+}
+
+#endif // XFILE_XFILE_WRITER_H_INCLUDED
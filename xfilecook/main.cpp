@@ -0,0 +1,779 @@
+﻿#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "xfile/XFileCookedMesh.h"
+#include "xfile/XFileHash.h"
+#include "xfile/XFileMappedFile.h"
+#include "xfile/XFileReader.h"
+#include "xfile/XFileThreadPool.h"
+#include "xfile/XFileWriter.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	// 変換結果が変わる修正を入れたら上げる．上げると全てのアセットを変換し直す
+	constexpr uint64_t CookerVersion = 3;
+
+	constexpr char CacheFileName[] = "xfilecook.cache";
+	constexpr char CacheFileHeader[] = "xfilecook 1";
+	constexpr char CookedExtension[] = ".xcm";
+
+	using Clock = std::chrono::steady_clock;
+
+	double toMilliseconds(Clock::duration duration)
+	{
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+
+	// 前回の実行時のファイルの状態
+	// サイズと更新時刻が同じなら中身を読まずに前回のハッシュを使う
+	struct FileStamp
+	{
+		uint64_t size = 0;
+		int64_t time = 0;
+		uint64_t hash = 0;
+	};
+
+	struct AssetRecord
+	{
+		uint64_t key = 0;
+		std::vector<std::string> dependencies;
+	};
+
+	struct CookCache
+	{
+		std::unordered_map<std::string, FileStamp> files;
+		std::unordered_map<std::string, AssetRecord> assets;
+
+		bool load(const fs::path & path);
+		bool save(const fs::path & path) const;
+	};
+
+	std::vector<std::string_view> splitTabs(std::string_view line)
+	{
+		std::vector<std::string_view> fields;
+		while(true)
+		{
+			auto position = line.find('\t');
+			fields.emplace_back(line.substr(0, position));
+			if(position == std::string_view::npos)
+			{
+				break;
+			}
+			line.remove_prefix(position + 1);
+		}
+
+		return fields;
+	}
+
+	bool CookCache::load(const fs::path & path)
+	{
+		std::ifstream fin(path);
+		std::string line;
+		if(!std::getline(fin, line) || line != CacheFileHeader)
+		{
+			return false;
+		}
+
+		while(std::getline(fin, line))
+		{
+			auto fields = splitTabs(line);
+			if(fields[0] == "F" && fields.size() == 5)
+			{
+				FileStamp stamp
+				{
+					.size = std::strtoull(std::string(fields[1]).c_str(), nullptr, 10),
+					.time = std::strtoll(std::string(fields[2]).c_str(), nullptr, 10),
+					.hash = std::strtoull(std::string(fields[3]).c_str(), nullptr, 16)
+				};
+				files.emplace(fields[4], stamp);
+			}
+			else if(fields[0] == "A" && fields.size() >= 3)
+			{
+				AssetRecord record
+				{
+					.key = std::strtoull(std::string(fields[1]).c_str(), nullptr, 16),
+					.dependencies = { fields.begin() + 3, fields.end() }
+				};
+				assets.emplace(fields[2], std::move(record));
+			}
+		}
+
+		return true;
+	}
+
+	bool CookCache::save(const fs::path & path) const
+	{
+		// 途中で止まっても壊れたキャッシュが残らないように，書き終えてから置き換える
+		auto temporary_path = path;
+		temporary_path += ".tmp";
+		{
+			std::ofstream fout(temporary_path);
+			fout << CacheFileHeader << '\n';
+
+			char buffer[64];
+			for(const auto & [file_path, stamp] : files)
+			{
+				snprintf(buffer, sizeof(buffer), "%" PRIu64 "\t%" PRId64 "\t%016" PRIx64, stamp.size, stamp.time, stamp.hash);
+				fout << "F\t" << buffer << '\t' << file_path << '\n';
+			}
+
+			for(const auto & [asset_path, record] : assets)
+			{
+				snprintf(buffer, sizeof(buffer), "%016" PRIx64, record.key);
+				fout << "A\t" << buffer << '\t' << asset_path;
+				for(const auto & dependency : record.dependencies)
+				{
+					fout << '\t' << dependency;
+				}
+				fout << '\n';
+			}
+
+			if(!fout)
+			{
+				return false;
+			}
+		}
+
+		std::error_code ec;
+		fs::rename(temporary_path, path, ec);
+
+		return !ec;
+	}
+
+	// 複数のアセットから参照されるテクスチャもあるので，ハッシュはスレッド間で共有する
+	class FileHasher
+	{
+	public:
+		FileHasher(const fs::path & root, const CookCache & previous)
+			: mRoot(root)
+			, mPrevious(previous)
+		{
+		}
+
+		bool hash(const std::string & relative_path, uint64_t & hash)
+		{
+			{
+				std::lock_guard lock(mMutex);
+				auto it = mFiles.find(relative_path);
+				if(it != mFiles.end())
+				{
+					hash = it->second.hash;
+					return true;
+				}
+			}
+
+			auto path = mRoot / fs::path(relative_path);
+			std::error_code ec;
+			FileStamp stamp
+			{
+				.size = fs::file_size(path, ec)
+			};
+			if(ec)
+			{
+				return false;
+			}
+
+			stamp.time = fs::last_write_time(path, ec).time_since_epoch().count();
+			if(ec)
+			{
+				return false;
+			}
+
+			auto it = mPrevious.files.find(relative_path);
+			if(it != mPrevious.files.end() && it->second.size == stamp.size && it->second.time == stamp.time)
+			{
+				stamp.hash = it->second.hash;
+			}
+			else
+			{
+				xfile::XFileMappedFile mapped_file;
+				if(stamp.size > 0 && !mapped_file.open(path.string().c_str()))
+				{
+					return false;
+				}
+				stamp.hash = xfile::hashBytes(mapped_file.bytes());
+			}
+
+			std::lock_guard lock(mMutex);
+			hash = mFiles.emplace(relative_path, stamp).first->second.hash;
+
+			return true;
+		}
+
+		const std::unordered_map<std::string, FileStamp> & files() const noexcept { return mFiles; }
+
+	private:
+		fs::path mRoot;
+		const CookCache & mPrevious;
+
+		std::mutex mMutex;
+		std::unordered_map<std::string, FileStamp> mFiles;
+	};
+
+	enum class CookStatus
+	{
+		UpToDate,
+		Cooked,
+		Failed,
+	};
+
+	struct CookResult
+	{
+		std::string path;
+		CookStatus status = CookStatus::Failed;
+		double milliseconds = 0.0;
+		AssetRecord record = {};
+		xfile::XFileCookedMeshStats stats = {};
+	};
+
+	struct CookContext
+	{
+		fs::path inputRoot;
+		fs::path outputRoot;
+		bool force = false;
+		const CookCache & previous;
+		FileHasher & hasher;
+	};
+
+	fs::path toCookedPath(const CookContext & context, const std::string & relative_path)
+	{
+		auto path = context.outputRoot / fs::path(relative_path);
+		path.replace_extension(CookedExtension);
+
+		return path;
+	}
+
+	uint64_t computeKey(const CookContext & context, uint64_t source_hash, const std::vector<std::string> & dependencies)
+	{
+		uint64_t key = xfile::combineHash(CookerVersion, source_hash);
+		for(const auto & dependency : dependencies)
+		{
+			// 見つからないテクスチャも，後から置かれたときに変換し直せるように0として混ぜる
+			uint64_t dependency_hash = 0;
+			context.hasher.hash(dependency, dependency_hash);
+			key = xfile::combineHash(key, dependency_hash);
+		}
+
+		return key;
+	}
+
+	// .xの場所を基準にしたテクスチャのパスを，入力のルートからのパスにする
+	std::vector<std::string> findDependencies(const std::string & relative_path, const xfile::XFile & xfile)
+	{
+		auto directory = fs::path(relative_path).parent_path();
+
+		std::vector<std::string> dependencies;
+		for(const auto & mesh : xfile.meshes)
+		{
+			for(const auto & material : mesh.materialList.materials)
+			{
+				const auto & filename = material.textureFilename.filename;
+				if(filename.empty())
+				{
+					continue;
+				}
+
+				auto dependency = (directory / fs::path(filename)).lexically_normal().generic_string();
+				if(std::find(dependencies.begin(), dependencies.end(), dependency) == dependencies.end())
+				{
+					dependencies.emplace_back(std::move(dependency));
+				}
+			}
+		}
+
+		return dependencies;
+	}
+
+	CookResult cookAsset(const CookContext & context, const std::string & relative_path)
+	{
+		auto start = Clock::now();
+		CookResult result
+		{
+			.path = relative_path
+		};
+
+		uint64_t source_hash;
+		if(!context.hasher.hash(relative_path, source_hash))
+		{
+			result.milliseconds = toMilliseconds(Clock::now() - start);
+			return result;
+		}
+
+		auto cooked_path = toCookedPath(context, relative_path);
+
+		// 依存するテクスチャは.xの中身で決まるので，.xが同じなら前回の一覧をそのまま使える
+		auto it = context.previous.assets.find(relative_path);
+		if(!context.force && it != context.previous.assets.end())
+		{
+			auto key = computeKey(context, source_hash, it->second.dependencies);
+			std::error_code ec;
+			if(key == it->second.key && fs::exists(cooked_path, ec))
+			{
+				result.status = CookStatus::UpToDate;
+				result.record = it->second;
+				result.milliseconds = toMilliseconds(Clock::now() - start);
+				return result;
+			}
+		}
+
+		xfile::XFileReader reader;
+		xfile::XFile xfile;
+		auto source_path = context.inputRoot / fs::path(relative_path);
+		if(!reader.open(source_path.string().c_str()) || !reader.read(xfile))
+		{
+			result.milliseconds = toMilliseconds(Clock::now() - start);
+			return result;
+		}
+
+		result.record.dependencies = findDependencies(relative_path, xfile);
+		result.record.key = computeKey(context, source_hash, result.record.dependencies);
+
+		std::error_code ec;
+		fs::create_directories(cooked_path.parent_path(), ec);
+
+		auto temporary_path = cooked_path;
+		temporary_path += ".tmp";
+		if(xfile::XFileCookedMesh::cook(xfile, temporary_path.string().c_str(), &result.stats))
+		{
+			fs::rename(temporary_path, cooked_path, ec);
+			if(!ec)
+			{
+				result.status = CookStatus::Cooked;
+			}
+		}
+
+		result.milliseconds = toMilliseconds(Clock::now() - start);
+
+		return result;
+	}
+
+	// テクスチャは変換せずに出力先へ写す．前回から中身が変わったものだけを写す
+	size_t copyDependencies(const CookContext & context, const CookCache & cache)
+	{
+		std::unordered_set<std::string> dependencies;
+		for(const auto & [asset_path, record] : cache.assets)
+		{
+			dependencies.insert(record.dependencies.begin(), record.dependencies.end());
+		}
+
+		size_t copied_count = 0;
+		for(const auto & dependency : dependencies)
+		{
+			auto current = cache.files.find(dependency);
+			if(current == cache.files.end() || dependency.starts_with(".."))
+			{
+				continue;
+			}
+
+			auto destination = context.outputRoot / fs::path(dependency);
+			auto previous = context.previous.files.find(dependency);
+
+			std::error_code ec;
+			if(!context.force
+				&& fs::exists(destination, ec)
+				&& previous != context.previous.files.end()
+				&& previous->second.hash == current->second.hash)
+			{
+				continue;
+			}
+
+			fs::create_directories(destination.parent_path(), ec);
+			if(fs::copy_file(context.inputRoot / fs::path(dependency), destination, fs::copy_options::overwrite_existing, ec))
+			{
+				++copied_count;
+			}
+			else
+			{
+				fprintf(stderr, "failed to copy %s\n", dependency.c_str());
+			}
+		}
+
+		return copied_count;
+	}
+
+	// 浮動小数点数も書き出した値がそのまま読み戻るはずなので，ビット単位で比べる
+	template <class T>
+	bool sameBytes(const T & a, const T & b)
+	{
+		return memcmp(&a, &b, sizeof(T)) == 0;
+	}
+
+	template <class T>
+	bool sameBytes(const std::vector<T> & a, const std::vector<T> & b)
+	{
+		return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), sizeof(T) * a.size()) == 0);
+	}
+
+	bool sameMaterial(const xfile::XFileMaterial & a, const xfile::XFileMaterial & b)
+	{
+		return sameBytes(a.faceColor, b.faceColor)
+			&& sameBytes(a.power, b.power)
+			&& sameBytes(a.specularColor, b.specularColor)
+			&& sameBytes(a.emissiveColor, b.emissiveColor)
+			&& a.textureFilename.filename == b.textureFilename.filename;
+	}
+
+	bool sameSkinWeights(const xfile::XFileSkinWeights & a, const xfile::XFileSkinWeights & b)
+	{
+		return a.transformNodeName == b.transformNodeName
+			&& a.frameIndex == b.frameIndex
+			&& a.vertexIndices == b.vertexIndices
+			&& sameBytes(a.weights, b.weights)
+			&& sameBytes(a.matrixOffset, b.matrixOffset);
+	}
+
+	// 書き出すときに多角形は三角形に分けたままになるので，triangulationは比べない
+	bool sameMesh(const xfile::XFileMesh & a, const xfile::XFileMesh & b)
+	{
+		if(a.name != b.name
+			|| a.frameIndex != b.frameIndex
+			|| !sameBytes(a.vertices, b.vertices)
+			|| a.faceIndices != b.faceIndices
+			|| !sameBytes(a.normals.normals, b.normals.normals)
+			|| a.normals.faceNormalIndices != b.normals.faceNormalIndices
+			|| !sameBytes(a.textureCoords.textureCoords, b.textureCoords.textureCoords)
+			|| a.materialList.faceIndexes != b.materialList.faceIndexes
+			|| a.materialList.materials.size() != b.materialList.materials.size()
+			|| !sameBytes(a.skinMeshHeader, b.skinMeshHeader)
+			|| a.skinWeights.size() != b.skinWeights.size()
+			|| !sameBytes(a.influences, b.influences))
+		{
+			return false;
+		}
+
+		for(size_t i = 0; i < a.materialList.materials.size(); ++i)
+		{
+			if(!sameMaterial(a.materialList.materials[i], b.materialList.materials[i]))
+			{
+				return false;
+			}
+		}
+
+		for(size_t i = 0; i < a.skinWeights.size(); ++i)
+		{
+			if(!sameSkinWeights(a.skinWeights[i], b.skinWeights[i]))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool sameAnimationSet(const xfile::XFileAnimationSet & a, const xfile::XFileAnimationSet & b)
+	{
+		if(a.name != b.name
+			|| !sameBytes(a.times, b.times)
+			|| !sameBytes(a.values, b.values)
+			|| a.outputSize != b.outputSize
+			|| a.channels.size() != b.channels.size())
+		{
+			return false;
+		}
+
+		for(size_t i = 0; i < a.channels.size(); ++i)
+		{
+			const auto & x = a.channels[i];
+			const auto & y = b.channels[i];
+			if(x.frameName != y.frameName
+				|| x.frameIndex != y.frameIndex
+				|| x.keyType != y.keyType
+				|| x.firstKey != y.firstKey
+				|| x.keyCount != y.keyCount
+				|| x.firstValue != y.firstValue
+				|| x.valueCount != y.valueCount
+				|| x.outputOffset != y.outputOffset)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool sameXFile(const xfile::XFile & a, const xfile::XFile & b)
+	{
+		if(a.frames.names != b.frames.names
+			|| a.frames.parents != b.frames.parents
+			|| !sameBytes(a.frames.localMatrices, b.frames.localMatrices)
+			|| !sameBytes(a.frames.worldMatrices, b.frames.worldMatrices)
+			|| a.meshes.size() != b.meshes.size()
+			|| a.animationSets.size() != b.animationSets.size())
+		{
+			return false;
+		}
+
+		for(size_t i = 0; i < a.meshes.size(); ++i)
+		{
+			if(!sameMesh(a.meshes[i], b.meshes[i]))
+			{
+				return false;
+			}
+		}
+
+		for(size_t i = 0; i < a.animationSets.size(); ++i)
+		{
+			if(!sameAnimationSet(a.animationSets[i], b.animationSets[i]))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// 読み込んでバイナリ形式で書き出し，それを読み直して内容が変わらないことと，
+	// 読み直したものをもう一度書き出して同じバイト列になることを確かめる
+	bool roundTrip(const fs::path & path)
+	{
+		xfile::XFileReader reader;
+		xfile::XFile original;
+		if(!reader.open(path.string().c_str()) || !reader.read(original))
+		{
+			printf("FAILED     read          %s\n", path.string().c_str());
+			return false;
+		}
+		reader.close();
+
+		xfile::XFileWriter writer;
+		std::vector<std::byte> bytes;
+		if(!writer.write(original, bytes))
+		{
+			printf("FAILED     write         %s\n", path.string().c_str());
+			return false;
+		}
+
+		xfile::XFileReader written_reader;
+		xfile::XFile written;
+		if(!written_reader.open(std::span<const std::byte>(bytes)) || !written_reader.read(written))
+		{
+			printf("FAILED     read back     %s\n", path.string().c_str());
+			return false;
+		}
+
+		std::vector<std::byte> rewritten_bytes;
+		if(!sameXFile(original, written) || !writer.write(written, rewritten_bytes) || rewritten_bytes != bytes)
+		{
+			printf("MISMATCH                 %s\n", path.string().c_str());
+			return false;
+		}
+
+		printf(
+			"ok         %zu meshes, %zu frames, %zu animation sets  %s\n",
+			original.meshes.size(),
+			original.frames.size(),
+			original.animationSets.size(),
+			path.string().c_str()
+		);
+
+		return true;
+	}
+
+	int runRoundTrip(const std::vector<std::string_view> & inputs)
+	{
+		std::vector<fs::path> paths;
+		for(auto input : inputs)
+		{
+			std::error_code ec;
+			fs::path path(input);
+			if(!fs::is_directory(path, ec))
+			{
+				paths.emplace_back(path);
+				continue;
+			}
+
+			std::vector<fs::path> found;
+			for(const auto & entry : fs::recursive_directory_iterator(path, ec))
+			{
+				if(entry.is_regular_file() && entry.path().extension() == ".x")
+				{
+					found.emplace_back(entry.path());
+				}
+			}
+			std::sort(found.begin(), found.end());
+			paths.insert(paths.end(), found.begin(), found.end());
+		}
+
+		size_t failed_count = 0;
+		for(const auto & path : paths)
+		{
+			failed_count += roundTrip(path) ? 0 : 1;
+		}
+
+		printf("%zu files, %zu failed\n", paths.size(), failed_count);
+
+		return paths.empty() || failed_count > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	void printUsage()
+	{
+		fprintf(stderr, "usage: xfilecook <input directory> <output directory> [-j threads] [-f]\n");
+		fprintf(stderr, "       xfilecook --roundtrip <file or directory>...\n");
+		fprintf(stderr, "  -j           number of worker threads (default: hardware concurrency)\n");
+		fprintf(stderr, "  -f           cook every asset even if it is up to date\n");
+		fprintf(stderr, "  --roundtrip  check that each .x file survives XFileWriter and XFileReader unchanged\n");
+		fprintf(stderr, "               xfilecook/roundtrip has samples in every supported format\n");
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	std::vector<std::string_view> positional;
+	size_t thread_count = std::max(1u, std::thread::hardware_concurrency());
+	bool force = false;
+	bool round_trip = false;
+	for(int i = 1; i < argc; ++i)
+	{
+		std::string_view arg = argv[i];
+		if(arg == "--roundtrip")
+		{
+			round_trip = true;
+		}
+		else if(arg == "-j" && i + 1 < argc)
+		{
+			thread_count = std::max<size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if(arg == "-f")
+		{
+			force = true;
+		}
+		else
+		{
+			positional.emplace_back(arg);
+		}
+	}
+
+	if(round_trip)
+	{
+		if(positional.empty())
+		{
+			printUsage();
+			return EXIT_FAILURE;
+		}
+
+		return runRoundTrip(positional);
+	}
+
+	if(positional.size() != 2)
+	{
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	auto start = Clock::now();
+
+	fs::path input_root(positional[0]);
+	fs::path output_root(positional[1]);
+
+	std::error_code ec;
+	if(!fs::is_directory(input_root, ec))
+	{
+		fprintf(stderr, "%s is not a directory\n", input_root.string().c_str());
+		return EXIT_FAILURE;
+	}
+	fs::create_directories(output_root, ec);
+
+	std::vector<std::string> sources;
+	for(const auto & entry : fs::recursive_directory_iterator(input_root, ec))
+	{
+		if(entry.is_regular_file() && entry.path().extension() == ".x")
+		{
+			sources.emplace_back(entry.path().lexically_relative(input_root).generic_string());
+		}
+	}
+	std::sort(sources.begin(), sources.end());
+
+	CookCache previous;
+	previous.load(output_root / CacheFileName);
+
+	FileHasher hasher(input_root, previous);
+	CookContext context
+	{
+		.inputRoot = input_root,
+		.outputRoot = output_root,
+		.force = force,
+		.previous = previous,
+		.hasher = hasher
+	};
+
+	std::vector<CookResult> results;
+	{
+		xfile::XFileThreadPool thread_pool(thread_count);
+		std::vector<std::future<CookResult>> futures;
+		futures.reserve(sources.size());
+		for(const auto & source : sources)
+		{
+			futures.emplace_back(thread_pool.submit([&context, &source] { return cookAsset(context, source); }));
+		}
+
+		for(auto & future : futures)
+		{
+			results.emplace_back(future.get());
+		}
+	}
+
+	CookCache cache;
+	size_t counts[3] = {};
+	for(auto & result : results)
+	{
+		constexpr const char * status_names[] = { "up-to-date", "cooked", "FAILED" };
+		printf("%-10s %10.2f ms  %s\n", status_names[static_cast<size_t>(result.status)], result.milliseconds, result.path.c_str());
+		++counts[static_cast<size_t>(result.status)];
+
+		// 頂点キャッシュの並べ替えの効果．ACMRは三角形あたり，ATVRは頂点あたりの頂点シェーダの実行回数
+		if(result.status == CookStatus::Cooked && result.stats.fifoBefore.triangleCount > 0)
+		{
+			const auto & stats = result.stats;
+			printf(
+				"%26sFIFO%zu ACMR %.3f -> %.3f ATVR %.3f -> %.3f, LRU%zu ACMR %.3f -> %.3f ATVR %.3f -> %.3f\n",
+				"",
+				xfile::XFileCookedMeshStats::FifoCacheSize,
+				stats.fifoBefore.acmr(), stats.fifoAfter.acmr(), stats.fifoBefore.atvr(), stats.fifoAfter.atvr(),
+				xfile::XFileCookedMeshStats::LruCacheSize,
+				stats.lruBefore.acmr(), stats.lruAfter.acmr(), stats.lruBefore.atvr(), stats.lruAfter.atvr()
+			);
+		}
+
+		// 失敗したアセットは記録しないので，次回も変換を試みる
+		if(result.status != CookStatus::Failed)
+		{
+			cache.assets.emplace(std::move(result.path), std::move(result.record));
+		}
+	}
+	cache.files = hasher.files();
+
+	size_t copied_count = copyDependencies(context, cache);
+
+	if(!cache.save(output_root / CacheFileName))
+	{
+		fprintf(stderr, "failed to write %s\n", CacheFileName);
+	}
+
+	printf(
+		"%zu cooked, %zu up to date, %zu failed, %zu textures copied in %.2f ms (%zu threads)\n",
+		counts[static_cast<size_t>(CookStatus::Cooked)],
+		counts[static_cast<size_t>(CookStatus::UpToDate)],
+		counts[static_cast<size_t>(CookStatus::Failed)],
+		copied_count,
+		toMilliseconds(Clock::now() - start),
+		thread_count
+	);
+
+	return counts[static_cast<size_t>(CookStatus::Failed)] == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
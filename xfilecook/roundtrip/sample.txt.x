@@ -0,0 +1,122 @@
+xof 0303txt 0032
+
+// xfilecook --roundtripで使う．フレーム，スキンメッシュ，アニメーションを1つずつ含む
+// 他の形式のファイルはこのファイルから作る
+
+Frame Root {
+ FrameTransformMatrix {
+  1.0,0.0,0.0,0.0,0.0,1.0,0.0,0.0,0.0,0.0,1.0,0.0,0.0,0.0,0.0,1.0;;
+ }
+
+ Frame Bone {
+  FrameTransformMatrix {
+   0.0,1.0,0.0,0.0,-1.0,0.0,0.0,0.0,0.0,0.0,1.0,0.0,0.0,2.0,0.0,1.0;;
+  }
+ }
+
+ Mesh Quad {
+  4;
+  -1.0;0.0;0.0;,
+  1.0;0.0;0.0;,
+  1.0;2.0;0.0;,
+  -1.0;2.0;0.0;;
+  2;
+  3;0,1,2;,
+  3;0,2,3;;
+
+  MeshNormals {
+   1;
+   0.0;0.0;-1.0;;
+   2;
+   3;0,0,0;,
+   3;0,0,0;;
+  }
+
+  MeshTextureCoords {
+   4;
+   0.0;1.0;,
+   1.0;1.0;,
+   1.0;0.0;,
+   0.0;0.0;;
+  }
+
+  MeshMaterialList {
+   2;
+   2;
+   0,
+   1;
+
+   Material {
+    1.0;1.0;1.0;1.0;;
+    5.0;
+    0.5;0.5;0.5;;
+    0.0;0.0;0.0;;
+
+    TextureFilename {
+     "sample.png";
+    }
+   }
+
+   Material {
+    1.0;0.0;0.0;1.0;;
+    0.0;
+    0.0;0.0;0.0;;
+    0.25;0.0;0.0;;
+   }
+  }
+
+  XSkinMeshHeader {
+   2;
+   2;
+   2;
+  }
+
+  SkinWeights {
+   "Root";
+   4;
+   0,1,2,3;
+   1.0,1.0,0.5,0.5;
+   1.0,0.0,0.0,0.0,0.0,1.0,0.0,0.0,0.0,0.0,1.0,0.0,0.0,0.0,0.0,1.0;;
+  }
+
+  SkinWeights {
+   "Bone";
+   2;
+   2,3;
+   0.5,0.5;
+   0.0,-1.0,0.0,0.0,1.0,0.0,0.0,0.0,0.0,0.0,1.0,0.0,2.0,0.0,0.0,1.0;;
+  }
+ }
+}
+
+AnimationSet Bend {
+ Animation {
+  { Bone }
+
+  AnimationKey {
+   0;
+   3;
+   0;4;1.0,0.0,0.0,0.0;;,
+   50;4;0.92388,0.0,0.0,0.382683;;,
+   100;4;0.707107,0.0,0.0,0.707107;;;
+  }
+
+  AnimationKey {
+   2;
+   2;
+   0;3;0.0,2.0,0.0;;,
+   100;3;0.0,2.5,0.0;;;
+  }
+ }
+
+ Animation {
+  { Root }
+
+  AnimationKey {
+   1;
+   2;
+   0;3;1.0,1.0,1.0;;,
+   100;3;2.0,2.0,2.0;;;
+  }
+ }
+}